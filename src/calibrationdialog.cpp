@@ -0,0 +1,328 @@
+/****************************************************************************
+**
+** SVG Cleaner could help you to clean up your SVG files
+** from unnecessary data.
+** Copyright (C) 2012-2018 Evgeniy Reizner
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License along
+** with this program; if not, write to the Free Software Foundation, Inc.,
+** 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+**
+****************************************************************************/
+
+#include <algorithm>
+
+#ifdef Q_OS_UNIX
+#include <sys/resource.h>
+#include <time.h>
+#endif
+
+#include <QElapsedTimer>
+#include <QFile>
+#include <QPushButton>
+#include <QTemporaryDir>
+#include <QtConcurrent/QtConcurrentRun>
+
+#include "settings.h"
+
+#include "calibrationdialog.h"
+#include "ui_calibrationdialog.h"
+
+// Enough to see the trend, but Zopfli on Ultra is still bearable.
+static const int SampleSize = 20;
+
+static const Compressor::Type Compressors[] = {
+    Compressor::SevenZip,
+    Compressor::Zopfli,
+    Compressor::Deflate,
+};
+
+static QString levelTitle(Compressor::Level lvl)
+{
+    switch (lvl) {
+        case Compressor::Lowest :   return CalibrationDialog::tr("Lowest");
+        case Compressor::Low :      return CalibrationDialog::tr("Low");
+        case Compressor::Normal :   return CalibrationDialog::tr("Normal");
+        case Compressor::Optimal :  return CalibrationDialog::tr("Optimal");
+        case Compressor::Ultra :    return CalibrationDialog::tr("Ultra");
+    }
+
+    Q_UNREACHABLE();
+}
+
+#ifdef Q_OS_UNIX
+static double toSeconds(const timeval &tv)
+{
+    return tv.tv_sec + tv.tv_usec / 1e6;
+}
+#endif
+
+// CPU time spent by the calling thread and by finished child processes,
+// since external compressors run as separate processes.
+// The main window doesn't start cleaning while calibrating, so the only children are ours.
+// Other platforms fall back to the wall-clock time.
+static double cpuSeconds(const QElapsedTimer &wallClock)
+{
+#ifdef Q_OS_UNIX
+    timespec ts;
+    rusage children;
+    if (   clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) == 0
+        && getrusage(RUSAGE_CHILDREN, &children) == 0) {
+        return ts.tv_sec + ts.tv_nsec / 1e9
+               + toSeconds(children.ru_utime) + toSeconds(children.ru_stime);
+    }
+#endif
+    return wallClock.nsecsElapsed() / 1e9;
+}
+
+static QVector<Compressor::Type> availableCompressors()
+{
+    QVector<Compressor::Type> list;
+    for (const Compressor::Type type : Compressors) {
+        if (Compressor(type).isAvailable()) {
+            list << type;
+        }
+    }
+    return list;
+}
+
+static QVector<CalibrationDialog::Point> calibrate(const QStringList &files,
+                                                   const QVector<Compressor::Type> &compressors,
+                                                   QAtomicInt *progress, QAtomicInt *isCanceled)
+{
+    QVector<CalibrationDialog::Point> points;
+
+    QTemporaryDir dir;
+    if (!dir.isValid()) {
+        return points;
+    }
+
+    const QString inPath = dir.path() + "/sample.svg";
+    const QString outPath = inPath + "z";
+
+    for (const Compressor::Type type : compressors) {
+        const Compressor c(type);
+        for (int i = Compressor::Lowest; i <= Compressor::Ultra; ++i) {
+            CalibrationDialog::Point p;
+            p.type = type;
+            p.level = Compressor::Level(i);
+
+            QElapsedTimer wallClock;
+            wallClock.start();
+            for (const QString &file : files) {
+                if (isCanceled->load()) {
+                    return QVector<CalibrationDialog::Point>();
+                }
+
+                // zip() removes the input file
+                QFile::remove(inPath);
+                if (!QFile::copy(file, inPath)) {
+                    progress->ref();
+                    continue;
+                }
+
+                const qint64 inSize = QFile(inPath).size();
+                try {
+                    const double started = cpuSeconds(wallClock);
+                    c.zip(p.level, inPath, outPath);
+                    p.seconds += cpuSeconds(wallClock) - started;
+                    p.inSize += inSize;
+                    p.saved += inSize - QFile(outPath).size();
+                } catch (...) {
+                    // the file is skipped
+                }
+
+                progress->ref();
+            }
+
+            points << p;
+        }
+    }
+
+    return points;
+}
+
+// Only the points that save more than all cheaper ones are worth considering.
+// The knee is the frontier point that is the most distant from a line
+// between the first and the last ones, with both axes normalized.
+static int findKnee(QVector<CalibrationDialog::Point> &points)
+{
+    QVector<int> order;
+    for (int i = 0; i < points.size(); ++i) {
+        if (points.at(i).inSize > 0) {
+            order << i;
+        }
+    }
+    std::sort(order.begin(), order.end(), [&points](int a, int b){
+        return points.at(a).seconds < points.at(b).seconds;
+    });
+
+    QVector<int> frontier;
+    for (const int idx : order) {
+        if (frontier.isEmpty() || points.at(idx).saved > points.at(frontier.last()).saved) {
+            frontier << idx;
+            points[idx].isFrontier = true;
+        }
+    }
+
+    if (frontier.isEmpty()) {
+        return -1;
+    }
+
+    if (frontier.size() < 3) {
+        return frontier.last();
+    }
+
+    const auto &first = points.at(frontier.first());
+    const auto &last = points.at(frontier.last());
+    const double timeRange = qMax(last.seconds - first.seconds, 1e-9);
+    const double savedRange = qMax<double>(last.saved - first.saved, 1);
+
+    int knee = frontier.last();
+    double maxDist = 0;
+    for (const int idx : frontier) {
+        const auto &p = points.at(idx);
+        const double t = (p.seconds - first.seconds) / timeRange;
+        const double s = (p.saved - first.saved) / savedRange;
+        if (s - t > maxDist) {
+            maxDist = s - t;
+            knee = idx;
+        }
+    }
+
+    return knee;
+}
+
+CalibrationDialog::CalibrationDialog(const QStringList &files, QWidget *parent)
+    : QDialog(parent)
+    , ui(new Ui::CalibrationDialog)
+    , m_btnUse(new QPushButton(tr("Use Recommended")))
+{
+    ui->setupUi(this);
+
+    ui->buttonBox->addButton(m_btnUse, QDialogButtonBox::ApplyRole);
+    m_btnUse->setEnabled(false);
+    connect(m_btnUse, &QPushButton::clicked, this, &CalibrationDialog::onUseRecommended);
+
+    const auto compressors = availableCompressors();
+    ui->progressBar->setMaximum(files.size() * compressors.size() * (Compressor::Ultra + 1));
+    ui->lblInfo->setText(tr("Compressing %n sample file(s) with each compressor and level...",
+                            "", files.size()));
+
+    m_progressTimer.setInterval(100);
+    connect(&m_progressTimer, &QTimer::timeout, [this](){
+        ui->progressBar->setValue(m_progress.load());
+    });
+    m_progressTimer.start();
+
+    connect(&m_watcher, &QFutureWatcher<QVector<Point>>::finished,
+            this, &CalibrationDialog::onFinished);
+    m_watcher.setFuture(QtConcurrent::run(&calibrate, files, compressors,
+                                          &m_progress, &m_isCanceled));
+}
+
+CalibrationDialog::~CalibrationDialog()
+{
+    // the background job uses our counters
+    m_isCanceled.store(1);
+    m_watcher.waitForFinished();
+
+    delete ui;
+}
+
+// Files are picked evenly, so a sample covers all parts of the tree.
+QStringList CalibrationDialog::sampleFiles(const QStringList &files)
+{
+    QStringList svgFiles;
+    for (const QString &file : files) {
+        if (!file.endsWith("z", Qt::CaseInsensitive)) {
+            svgFiles << file;
+        }
+    }
+
+    if (svgFiles.size() <= SampleSize) {
+        return svgFiles;
+    }
+
+    QStringList sample;
+    for (int i = 0; i < SampleSize; ++i) {
+        sample << svgFiles.at(i * svgFiles.size() / SampleSize);
+    }
+    return sample;
+}
+
+void CalibrationDialog::onFinished()
+{
+    m_progressTimer.stop();
+    ui->progressBar->hide();
+
+    m_points = m_watcher.result();
+    m_recommended = findKnee(m_points);
+
+    if (m_recommended == -1) {
+        ui->lblInfo->setText(tr("Calibration failed. No files were compressed."));
+        return;
+    }
+
+    ui->tableWidget->setRowCount(m_points.size());
+    for (int row = 0; row < m_points.size(); ++row) {
+        const Point &p = m_points.at(row);
+        const Compressor c(p.type);
+
+        const QStringList cells = {
+            c.name(),
+            levelTitle(p.level),
+            c.levelToString(p.level),
+            p.inSize > 0 ? QString::number(double(p.saved) / p.inSize * 100, 'f', 2) + "%"
+                         : QString("-"),
+            QString::number(p.saved),
+            QString::number(p.seconds, 'f', 2),
+        };
+
+        for (int col = 0; col < cells.size(); ++col) {
+            auto cell = new QTableWidgetItem(cells.at(col));
+            if (col >= 3) {
+                cell->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
+            }
+            if (!p.isFrontier) {
+                cell->setForeground(palette().color(QPalette::Disabled, QPalette::Text));
+            }
+            if (row == m_recommended) {
+                QFont font = cell->font();
+                font.setBold(true);
+                cell->setFont(font);
+            }
+            ui->tableWidget->setItem(row, col, cell);
+        }
+    }
+    ui->tableWidget->resizeColumnsToContents();
+
+    const Point &best = m_points.at(m_recommended);
+    ui->lblInfo->setText(tr("Recommended: %1, %2. Grayed out levels are slower "
+                            "than others that save the same or more.")
+                         .arg(Compressor(best.type).name(), levelTitle(best.level)));
+
+    m_btnUse->setEnabled(true);
+}
+
+void CalibrationDialog::onUseRecommended()
+{
+    const Point &best = m_points.at(m_recommended);
+
+    AppSettings settings;
+    settings.setValue(SettingKey::UseCompression, true);
+    settings.setValue(SettingKey::Compressor, Compressor(best.type).name());
+    settings.setValue(SettingKey::CompressionLevel, int(best.level));
+
+    accept();
+}
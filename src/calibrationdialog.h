@@ -0,0 +1,72 @@
+/****************************************************************************
+**
+** SVG Cleaner could help you to clean up your SVG files
+** from unnecessary data.
+** Copyright (C) 2012-2018 Evgeniy Reizner
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License along
+** with this program; if not, write to the Free Software Foundation, Inc.,
+** 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+**
+****************************************************************************/
+
+#pragma once
+
+#include <QDialog>
+#include <QFutureWatcher>
+#include <QTimer>
+
+#include "compressor.h"
+
+namespace Ui {
+class CalibrationDialog;
+}
+
+class QPushButton;
+
+// Runs every compressor and level on a sample of files and recommends the level
+// at the knee of the bytes saved / CPU seconds curve.
+class CalibrationDialog : public QDialog
+{
+    Q_OBJECT
+
+public:
+    struct Point
+    {
+        Compressor::Type type = Compressor::None;
+        Compressor::Level level = Compressor::Lowest;
+        qint64 inSize = 0;
+        qint64 saved = 0;
+        double seconds = 0;
+        bool isFrontier = false;
+    };
+
+    explicit CalibrationDialog(const QStringList &files, QWidget *parent = nullptr);
+    ~CalibrationDialog();
+
+    static QStringList sampleFiles(const QStringList &files);
+
+private:
+    void onFinished();
+    void onUseRecommended();
+
+private:
+    Ui::CalibrationDialog * const ui;
+    QPushButton * const m_btnUse;
+    QFutureWatcher<QVector<Point>> m_watcher;
+    QTimer m_progressTimer;
+    QAtomicInt m_progress;
+    QAtomicInt m_isCanceled;
+    int m_recommended = -1;
+    QVector<Point> m_points;
+};
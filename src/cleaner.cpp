@@ -21,11 +21,129 @@
 ****************************************************************************/
 
 #include <QDir>
+#include <QDateTime>
+#include <QScopedPointer>
+#include <QTemporaryDir>
+
+#if QT_VERSION < QT_VERSION_CHECK(5, 10, 0)
+#ifdef Q_OS_WIN
+#include <sys/utime.h>
+#else
+#include <utime.h>
+#endif
+#endif
 
 #include "utils.h"
 #include "cleaner.h"
 #include "process.h"
 
+// Static web servers expect precompressed copies to have the same mtime.
+static void copyFileTime(const QString &from, const QString &to)
+{
+    const QDateTime time = QFileInfo(from).lastModified();
+
+#if QT_VERSION >= QT_VERSION_CHECK(5, 10, 0)
+    QFile file(to);
+    if (file.open(QFile::ReadWrite)) {
+        file.setFileTime(time, QFileDevice::FileModificationTime);
+    }
+#elif defined(Q_OS_WIN)
+    struct _utimbuf buf;
+    buf.actime = buf.modtime = time.toTime_t();
+    _wutime(reinterpret_cast<const wchar_t*>(to.utf16()), &buf);
+#else
+    struct utimbuf buf;
+    buf.actime = buf.modtime = time.toTime_t();
+    utime(QFile::encodeName(to).constData(), &buf);
+#endif
+}
+
+static QByteArray readFile(const QString &path)
+{
+    QFile file(path);
+    if (!file.open(QFile::ReadOnly)) {
+        throw Task::tr("Failed to open a file:\n'%1'.").arg(path);
+    }
+    return file.readAll();
+}
+
+// QFile::rename() doesn't overwrite existing files.
+// The temporary folder can be on another file system.
+static void replaceFile(const QString &from, const QString &to)
+{
+    QFile(to).remove();
+    if (QFile::rename(from, to)) {
+        return;
+    }
+
+    if (!QFile::copy(from, to)) {
+        throw Task::tr("Failed to create a file:\n'%1'.").arg(to);
+    }
+    QFile(from).remove();
+}
+
+// Returns a path of the kept file. In the overwrite mode it's the input file itself,
+// so nothing is written.
+static QString keepOriginal(const Task::Config &config, bool isInputFileCompressed)
+{
+    QString path = config.outputPath;
+    if (isInputFileCompressed) {
+        // preserve the case of the SVGZ extension
+        path += config.inputPath.right(1);
+    }
+
+    if (path != config.inputPath) {
+        QFile(path).remove();
+        if (!QFile::copy(config.inputPath, path)) {
+            throw Task::tr("Failed to create a file:\n'%1'.").arg(path);
+        }
+    }
+
+    return path;
+}
+
+// Returns written copies. Ones that don't beat the SVG by the threshold are removed.
+static QVector<Task::Output::Artifact> writeSidecars(const Task::Config &config, qint64 svgSize)
+{
+    // zip() removes the input file, so it gets a copy. The copy is kept out of
+    // the watched folders and has the original name, since 7za stores it in the gzip header.
+    QTemporaryDir dir;
+    if (!dir.isValid()) {
+        throw Task::tr("Failed to create a temporary folder.");
+    }
+    const QString tmpPath = dir.path() + "/" + QFileInfo(config.outputPath).fileName();
+
+    QVector<Task::Output::Artifact> artifacts;
+    for (const Compressor::Type type : config.sidecars) {
+        Compressor c(type);
+        c.setDictionary(config.zstdDictionary);
+        c.setCandidates(config.bestOfCompressors);
+        c.setBlockMode(config.blockThreshold, config.blockPool);
+        const QString path = config.outputPath + c.sidecarSuffix();
+
+        QFile(tmpPath).remove();
+        if (!QFile::copy(config.outputPath, tmpPath)) {
+            throw Task::tr("Failed to create a file:\n'%1'.").arg(tmpPath);
+        }
+        c.zip(config.compressionLevel, tmpPath, path, config.isParallelZip);
+
+        const qint64 size = QFile(path).size();
+        if (size > svgSize * (100 - config.sidecarThreshold) / 100) {
+            QFile(path).remove();
+            continue;
+        }
+
+        copyFileTime(config.outputPath, path);
+
+        Task::Output::Artifact artifact;
+        artifact.path = path;
+        artifact.size = size;
+        artifacts << artifact;
+    }
+
+    return artifacts;
+}
+
 Task::Output Task::cleanFile(const Task::Config &config)
 {
     Q_ASSERT(config.inputPath.isEmpty() == false);
@@ -53,22 +171,53 @@ Task::Output Task::_cleanFile(const Task::Config &config)
         }
     }
 
+    const bool isSkipUnchanged = config.unchangedThreshold > 0;
+    const QString inSuffix = QFileInfo(config.inputPath).suffix().toLower();
+    const bool isInputFileCompressed = inSuffix == "svgz";
+
+    // Intermediate files are kept out of the watched folders, so a no-op result
+    // doesn't touch the output folder at all.
+    QScopedPointer<QTemporaryDir> tmpDir;
+    if (isSkipUnchanged || isInputFileCompressed) {
+        tmpDir.reset(new QTemporaryDir());
+        if (!tmpDir->isValid()) {
+            throw tr("Failed to create a temporary folder.");
+        }
+    }
+
+    // Clean into a temporary file, so a no-op result doesn't touch the output.
+    const QString fileName = QFileInfo(config.outputPath).fileName();
+    QString cleanPath = config.outputPath;
+    if (isSkipUnchanged) {
+        const QString cleanDir = tmpDir->path() + "/cleaned";
+        if (!QDir().mkpath(cleanDir)) {
+            throw tr("Failed to create a temporary folder.");
+        }
+        cleanPath = cleanDir + "/" + fileName;
+    }
+
     // take before cleaning in case of an overwrite mode
     const auto inSize = QFile(config.inputPath).size();
 
     // unzip svgz
     QString inputFile = config.inputPath;
-    const QString inSuffix = QFileInfo(config.inputPath).suffix().toLower();
-    const bool isInputFileCompressed = inSuffix == "svgz";
     if (isInputFileCompressed) {
-        inputFile = config.outputPath;
+        inputFile = tmpDir->path() + "/" + fileName;
         Compressor::unzip(config.inputPath, inputFile);
     }
 
+    // read before cleaning, since the input can be overwritten
+    Transfer::Sizes transferBefore;
+    if (config.isTransferEstimated) {
+        transferBefore = Transfer::estimate(readFile(inputFile));
+    }
+
+    const qint64 svgSize = QFile(inputFile).size();
+
     // clean file
     QStringList args;
     args.reserve(config.args.size() + 3);
-    args << config.args << "--quiet" << inputFile << config.outputPath;
+    args << config.args << "--quiet" << inputFile << cleanPath;
 
     // TODO: make timeout optional
     QString cleanerMsg = Process::run(Cleaner::Name, args, 300000, true);
@@ -78,13 +227,36 @@ Task::Output Task::_cleanFile(const Task::Config &config)
     if (cleanerMsg.contains("Error:")) {
         // NOTE: have to keep it in sync with CLI
         if (isInputFileCompressed) {
-            // remove decompressed file
-            QFile().remove(inputFile);
+            // the decompressed file is removed with the temporary folder
+            QFile().remove(cleanPath);
+        } else if (isSkipUnchanged && QFile::exists(cleanPath)) {
+            // a copy made by the 'Copy on error' option
+            replaceFile(cleanPath, config.outputPath);
         }
 
         return Output::error(cleanerMsg, config.treeItem);
     }
 
+    if (isSkipUnchanged) {
+        const qint64 saved = svgSize - QFile(cleanPath).size();
+        if (saved < config.unchangedThreshold) {
+            QFile().remove(cleanPath);
+
+            // reuse the original bytes, so there is nothing to compress
+            Output::OkData okData;
+            okData.outputPath = keepOriginal(config, isInputFileCompressed);
+            okData.outSize = inSize;
+            okData.transferBefore = transferBefore;
+            okData.transferAfter = transferBefore;
+
+            const QString msg = tr("Cleaning saves only %n byte(s), so the original file is kept.",
+                                   "", int(qMax(saved, qint64(0))));
+            return Output::unchanged(okData, msg, config.treeItem);
+        }
+
+        replaceFile(cleanPath, config.outputPath);
+    }
+
     // compress file
     QString outPath = config.outputPath;
 
@@ -101,13 +273,33 @@ Task::Output Task::_cleanFile(const Task::Config &config)
         }
     }
 
+    Output::OkData okData;
+
+    // the SVG itself, regardless of the compression below
+    if (config.isTransferEstimated) {
+        okData.transferBefore = transferBefore;
+        okData.transferAfter = Transfer::estimate(readFile(config.outputPath));
+    }
+
+    if (!config.sidecars.isEmpty()) {
+        shouldCompress = false;
+
+        Output::Artifact svg;
+        svg.path = config.outputPath;
+        svg.size = QFile(config.outputPath).size();
+        okData.artifacts << svg << writeSidecars(config, svg.size);
+    }
+
     if (shouldCompress) {
-        outPath += "z";
-        Compressor(config.compressorType).zip(config.compressionLevel,
-                                              config.outputPath, outPath);
+        Compressor c(config.compressorType);
+        c.setDictionary(config.zstdDictionary);
+        c.setCandidates(config.bestOfCompressors);
+        c.setBlockMode(config.blockThreshold, config.blockPool);
+        outPath += c.outputSuffix();
+        okData.zipStats = c.zip(config.compressionLevel, config.outputPath, outPath,
+                                config.isParallelZip);
     }
 
-    Output::OkData okData;
     okData.outSize = QFile(outPath).size();
     okData.ratio = Utils::cleanerRatio(inSize, okData.outSize);
     okData.outputPath = outPath;
@@ -118,3 +310,50 @@ Task::Output Task::_cleanFile(const Task::Config &config)
 
     return Output::ok(okData, config.treeItem);
 }
+
+QDataStream& operator<<(QDataStream &out, const Compressor::Stats &stats)
+{
+    return out << qint32(stats.type) << qint32(stats.iterations) << stats.gain;
+}
+
+QDataStream& operator>>(QDataStream &in, Compressor::Stats &stats)
+{
+    qint32 type = 0;
+    qint32 iterations = 0;
+    in >> type >> iterations >> stats.gain;
+    stats.type = Compressor::Type(type);
+    stats.iterations = iterations;
+    return in;
+}
+
+QDataStream& operator<<(QDataStream &out, const Transfer::Sizes &sizes)
+{
+    return out << sizes.gzip << sizes.brotli;
+}
+
+QDataStream& operator>>(QDataStream &in, Transfer::Sizes &sizes)
+{
+    return in >> sizes.gzip >> sizes.brotli;
+}
+
+QDataStream& operator<<(QDataStream &out, const Task::Output::Artifact &artifact)
+{
+    return out << artifact.path << artifact.size;
+}
+
+QDataStream& operator>>(QDataStream &in, Task::Output::Artifact &artifact)
+{
+    return in >> artifact.path >> artifact.size;
+}
+
+QDataStream& operator<<(QDataStream &out, const Task::Output::OkData &data)
+{
+    return out << data.ratio << data.outSize << data.outputPath << data.zipStats
+               << data.artifacts << data.transferBefore << data.transferAfter;
+}
+
+QDataStream& operator>>(QDataStream &in, Task::Output::OkData &data)
+{
+    return in >> data.ratio >> data.outSize >> data.outputPath >> data.zipStats
+              >> data.artifacts >> data.transferBefore >> data.transferAfter;
+}
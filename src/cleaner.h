@@ -24,10 +24,13 @@
 
 #include <QStringList>
 #include <QCoreApplication>
+#include <QDataStream>
 
 #include "enums.h"
 #include "compressor.h"
+#include "transfer.h"
 
+class QThreadPool;
 class TreeItem;
 
 class Task
@@ -44,16 +47,42 @@ public:
         Compressor::Type compressorType;
         Compressor::Level compressionLevel = Compressor::Ultra;
         bool compressOnlySvgz = false;
+        bool isParallelZip = false;
+        QVector<Compressor::Type> bestOfCompressors;
+        qint64 blockThreshold = 0;
+        // Blocks of large files are compressed on idle threads of it. Set by Scheduler.
+        QThreadPool *blockPool = nullptr;
+        // When set, the SVG file is kept and compressed copies are written next to it.
+        QVector<Compressor::Type> sidecars;
+        // Copies that don't save this percent of the SVG size are not written.
+        int sidecarThreshold = 0;
+        QString zstdDictionary;
+        // Estimate transfer sizes of the input and the cleaned SVG.
+        bool isTransferEstimated = false;
+        // Results that save fewer bytes keep the original file. Zero disables the check.
+        int unchangedThreshold = 0;
     };
 
     class Output
     {
     public:
+        struct Artifact
+        {
+            QString path;
+            qint64 size = 0;
+        };
+
         struct OkData
         {
             float ratio = 0;
             qint64 outSize = 0;
             QString outputPath;
+            Compressor::Stats zipStats;
+            // All written files, including the SVG itself in the sidecars mode.
+            QVector<Artifact> artifacts;
+            // Empty when not estimated.
+            Transfer::Sizes transferBefore;
+            Transfer::Sizes transferAfter;
         };
 
         struct WarningData
@@ -86,6 +115,15 @@ public:
             return s;
         }
 
+        static Output unchanged(const OkData &data, const QString &msg, TreeItem *treeItem)
+        {
+            Output s(treeItem);
+            s.m_type = Status::Unchanged;
+            s.m_ok = data;
+            s.m_msg = msg;
+            return s;
+        }
+
         static Output error(const QString &errMsg, TreeItem *treeItem)
         {
             Output s(treeItem);
@@ -99,7 +137,8 @@ public:
 
         const OkData& okData() const
         {
-            Q_ASSERT(m_type == Status::Ok || m_type == Status::Warning);
+            Q_ASSERT(   m_type == Status::Ok || m_type == Status::Warning
+                     || m_type == Status::Unchanged);
             return m_ok;
         }
 
@@ -109,6 +148,12 @@ public:
             return m_msg;
         }
 
+        QString unchangedMsg() const
+        {
+            Q_ASSERT(m_type == Status::Unchanged);
+            return m_msg;
+        }
+
         QString errorMsg() const
         {
             Q_ASSERT(m_type == Status::Error);
@@ -133,3 +178,13 @@ public:
 private:
     static Output _cleanFile(const Config &config);
 };
+
+// Results are stored by the journal and the session.
+QDataStream& operator<<(QDataStream &out, const Compressor::Stats &stats);
+QDataStream& operator>>(QDataStream &in, Compressor::Stats &stats);
+QDataStream& operator<<(QDataStream &out, const Transfer::Sizes &sizes);
+QDataStream& operator>>(QDataStream &in, Transfer::Sizes &sizes);
+QDataStream& operator<<(QDataStream &out, const Task::Output::Artifact &artifact);
+QDataStream& operator>>(QDataStream &in, Task::Output::Artifact &artifact);
+QDataStream& operator<<(QDataStream &out, const Task::Output::OkData &data);
+QDataStream& operator>>(QDataStream &in, Task::Output::OkData &data);
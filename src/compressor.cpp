@@ -20,15 +20,26 @@
 **
 ****************************************************************************/
 
+#include <QAtomicInt>
+#include <QDir>
 #include <QFile>
+#include <QFileInfo>
+#include <QTemporaryDir>
+#include <QtConcurrent/QtConcurrentMap>
 
+#include "gzip.h"
 #include "process.h"
+#include "zopflilib.h"
 #include "compressor.h"
 
 namespace CompressorName
 {
     const QString SevenZip = "7za";
     const QString Zopfli = "zopfli";
+    const QString Deflate = "deflate";
+    const QString BestOf = "best";
+    const QString Brotli = "brotli";
+    const QString Zstd = "zstd";
 }
 
 Compressor Compressor::fromName(const QString &aname) noexcept
@@ -37,6 +48,14 @@ Compressor Compressor::fromName(const QString &aname) noexcept
         return Compressor(SevenZip);
     } else if (aname == Compressor(Zopfli).name()) {
         return Compressor(Zopfli);
+    } else if (aname == Compressor(Deflate).name()) {
+        return Compressor(Deflate);
+    } else if (aname == Compressor(BestOf).name()) {
+        return Compressor(BestOf);
+    } else if (aname == Compressor(Brotli).name()) {
+        return Compressor(Brotli);
+    } else if (aname == Compressor(Zstd).name()) {
+        return Compressor(Zstd);
     }
 
     Q_UNREACHABLE();
@@ -51,11 +70,25 @@ bool Compressor::isAvailable() const
             return false;
         }
     } else if (m_type == Zopfli) {
+        if (ZopfliLib::isAvailable()) {
+            return true;
+        }
+
         try {
             Process::run(CompressorName::Zopfli, { "-h" }, 1000);
         } catch (...) {
             return false;
         }
+    } else if (m_type == Deflate) {
+        return Gzip::isAvailable();
+    } else if (m_type == BestOf) {
+        return raceCompressors().size() > 1;
+    } else if (m_type == Brotli || m_type == Zstd) {
+        try {
+            Process::run(name(), { "-h" }, 1000);
+        } catch (...) {
+            return false;
+        }
     } else {
         Q_UNREACHABLE();
     }
@@ -74,15 +107,20 @@ QString Compressor::levelToString(Level v) const noexcept
             case Level::Ultra :     return "-mx9";
         default: break;
         }
-    } else {
-        switch (v) {
-            case Level::Lowest :    return "--i1";
-            case Level::Low :       return "--i15";
-            case Level::Normal :    return "--i50";
-            case Level::Optimal :   return "--i100";
-            case Level::Ultra :     return "--i500";
-        default: break;
+    } else if (m_type == Deflate) {
+        return QString("%1 -%2").arg(Gzip::backendName()).arg(deflateLevel(v));
+    } else if (m_type == BestOf) {
+        QStringList list;
+        for (const Type type : raceCompressors()) {
+            list << Compressor(type).name() + " " + Compressor(type).levelToString(v);
         }
+        return list.join(", ");
+    } else if (m_type == Brotli) {
+        return brotliArgs(v).join(' ');
+    } else if (m_type == Zstd) {
+        return zstdArgs(v).join(' ');
+    } else {
+        return QString("--i%1").arg(zopfliIterations(v));
     }
 
     Q_UNREACHABLE();
@@ -94,11 +132,101 @@ QString Compressor::name() const noexcept
         case None : Q_UNREACHABLE();
         case SevenZip : return CompressorName::SevenZip;
         case Zopfli : return CompressorName::Zopfli;
+        case Deflate : return CompressorName::Deflate;
+        case BestOf : return CompressorName::BestOf;
+        case Brotli : return CompressorName::Brotli;
+        case Zstd : return CompressorName::Zstd;
+    }
+
+    Q_UNREACHABLE();
+}
+
+QString Compressor::outputSuffix() const noexcept
+{
+    switch (m_type) {
+        case None : Q_UNREACHABLE();
+        case Brotli : return ".br";
+        case Zstd : return ".zst";
+        default : return "z"; // svgz
+    }
+}
+
+QString Compressor::sidecarSuffix() const noexcept
+{
+    const QString suffix = outputSuffix();
+    return suffix == "z" ? ".gz" : suffix;
+}
+
+int Compressor::deflateLevel(Level v) const noexcept
+{
+    switch (v) {
+        case Level::Lowest :    return 1;
+        case Level::Low :       return 3;
+        case Level::Normal :    return 6;
+        case Level::Optimal :   return 9;
+        case Level::Ultra :     return Gzip::maxLevel();
+    default: break;
+    }
+
+    Q_UNREACHABLE();
+}
+
+int Compressor::zopfliIterations(Level v) const noexcept
+{
+    switch (v) {
+        case Level::Lowest :    return 1;
+        case Level::Low :       return 15;
+        case Level::Normal :    return 50;
+        case Level::Optimal :   return 100;
+        case Level::Ultra :     return 500;
+    default: break;
+    }
+
+    Q_UNREACHABLE();
+}
+
+// The window is limited to 16MiB (-w 24), because browsers can't decode
+// streams with a large window.
+QStringList Compressor::brotliArgs(Level v) const noexcept
+{
+    switch (v) {
+        case Level::Lowest :    return { "-q", "1", "-w", "24" };
+        case Level::Low :       return { "-q", "4", "-w", "24" };
+        case Level::Normal :    return { "-q", "6", "-w", "24" };
+        case Level::Optimal :   return { "-q", "9", "-w", "24" };
+        case Level::Ultra :     return { "-q", "11", "-w", "24" };
+    default: break;
+    }
+
+    Q_UNREACHABLE();
+}
+
+// The long mode window is reduced by zstd to the file size, so the output
+// is still decodable with the default window limit.
+QStringList Compressor::zstdArgs(Level v) const noexcept
+{
+    switch (v) {
+        case Level::Lowest :    return { "-1" };
+        case Level::Low :       return { "-3" };
+        case Level::Normal :    return { "-9" };
+        case Level::Optimal :   return { "-19", "--long" };
+        case Level::Ultra :     return { "--ultra", "-22", "--long" };
+    default: break;
     }
 
     Q_UNREACHABLE();
 }
 
+static QByteArray readFile(const QString &path)
+{
+    QFile file(path);
+    if (!file.open(QFile::ReadOnly)) {
+        throw QString("Failed to read a file: '%1'.").arg(path);
+    }
+
+    return file.readAll();
+}
+
 static void writeFile(const QString &path, const QByteArray &data)
 {
     QFile file(path);
@@ -119,17 +247,60 @@ void Compressor::unzip(const QString &inFile, const QString &outFile)
     writeFile(outFile, text);
 }
 
-void Compressor::zip(Level lvl, const QString &inFile, const QString &outFile) const
+Compressor::Stats Compressor::zip(Level lvl, const QString &inFile, const QString &outFile,
+                                  bool isParallel) const
 {
+    // Most files stop improving long before the max iterations count.
+    static const int ZopfliPatience = 10;
+    static const int ZopfliTimeBudget = 30000; // 30sec per file
+
     // remove previously created svgz file
     QFile(outFile).remove();
 
+    Stats stats;
+
+    if (m_blockThreshold > 0 && QFileInfo(inFile).size() > m_blockThreshold) {
+        const QVector<Type> types = blockCompressors();
+        if (!types.isEmpty()) {
+            return zipBlocks(lvl, types, inFile, outFile);
+        }
+    }
+
+    if (m_type == BestOf) {
+        return zipBestOf(lvl, inFile, outFile, isParallel);
+    }
+
+    stats.type = m_type;
+
+    // compressed in memory, so only the result is written
+    if (m_type == Deflate) {
+        writeFile(outFile, Gzip::compress(readFile(inFile), deflateLevel(lvl)));
+        QFile(inFile).remove();
+        return stats;
+    } else if (m_type == Zopfli && ZopfliLib::isAvailable()) {
+        const auto res = ZopfliLib::compress(readFile(inFile), zopfliIterations(lvl),
+                                             ZopfliPatience, ZopfliTimeBudget);
+        writeFile(outFile, res.data);
+        QFile(inFile).remove();
+
+        stats.iterations = res.iterations;
+        stats.gain = res.gain;
+        return stats;
+    }
+
     const QString lvlStr = levelToString(lvl);
-    if (m_type == SevenZip) {
+    if (m_type == Brotli) {
+        Process::run(name(), QStringList() << brotliArgs(lvl) << "-f" << "-o" << outFile << inFile,
+                     600000);
+    } else if (m_type == Zstd) {
+        QStringList args = QStringList() << "-q" << "-f" << zstdArgs(lvl);
+        if (!m_dictionary.isEmpty()) {
+            args << "-D" << m_dictionary;
+        }
+        Process::run(name(), args << "-o" << outFile << inFile, 600000);
+    } else if (m_type == SevenZip) {
         Process::run(name(), { "a", "-tgzip", "-y", lvlStr, outFile, inFile });
     } else if (m_type == Zopfli) {
-        // TODO: generate stat to find max --i value that is actually make sense
-
         // we save zopfli output manually, because it doesn't support setting an output file name
         const QByteArray ba = Process::run(name(), { "-c", lvlStr, inFile }, 600000); // 10min
         writeFile(outFile, ba);
@@ -139,4 +310,196 @@ void Compressor::zip(Level lvl, const QString &inFile, const QString &outFile) c
 
     // remove svg file
     QFile(inFile).remove();
+
+    return stats;
+}
+
+QVector<Compressor::Type> Compressor::gzipCompressors()
+{
+    return { SevenZip, Zopfli, Deflate };
+}
+
+QVector<Compressor::Type> Compressor::raceCompressors() const
+{
+    QVector<Type> list;
+    for (const Type type : (m_candidates.isEmpty() ? gzipCompressors() : m_candidates)) {
+        if (Compressor(type).isAvailable()) {
+            list << type;
+        }
+    }
+    return list;
+}
+
+bool Compressor::isBlockModeAvailable()
+{
+    return Gzip::isParallelAvailable();
+}
+
+// 7za and the zopfli executable can't deflate a part of a file.
+QVector<Compressor::Type> Compressor::blockCompressors() const
+{
+    if (!isBlockModeAvailable()) {
+        return {};
+    }
+
+    const QVector<Type> types = m_type == BestOf ? raceCompressors() : QVector<Type>{ m_type };
+
+    QVector<Type> list;
+    for (const Type type : types) {
+        if (type == Deflate || (type == Zopfli && ZopfliLib::isAvailable())) {
+            list << type;
+        }
+    }
+    return list;
+}
+
+// BestOf keeps the smallest output per block.
+Compressor::Stats Compressor::zipBlocks(Level lvl, const QVector<Type> &types,
+                                        const QString &inFile, const QString &outFile) const
+{
+    const QByteArray data = readFile(inFile);
+    const int level = deflateLevel(lvl);
+    const int iterations = zopfliIterations(lvl);
+
+    QAtomicInt deflateBlocks;
+    QAtomicInt zopfliBlocks;
+    const auto deflater = [&](int start, int size, bool isLast){
+        QByteArray best;
+        Type bestType = None;
+        for (const Type type : types) {
+            const QByteArray block = type == Zopfli
+                ? ZopfliLib::deflateBlock(data, start, size, iterations, isLast)
+                : Gzip::deflateBlock(data, start, size, level, isLast);
+            if (!block.isEmpty() && (best.isEmpty() || block.size() < best.size())) {
+                best = block;
+                bestType = type;
+            }
+        }
+
+        if (bestType == Zopfli) {
+            zopfliBlocks.ref();
+        } else if (bestType == Deflate) {
+            deflateBlocks.ref();
+        }
+        return best;
+    };
+
+    writeFile(outFile, Gzip::compressParallel(data, deflater, m_blockPool));
+    QFile(inFile).remove();
+
+    // the compressor of most blocks
+    Stats stats;
+    if (zopfliBlocks.load() > deflateBlocks.load()) {
+        stats.type = Zopfli;
+        stats.iterations = iterations;
+    } else {
+        stats.type = Deflate;
+    }
+    return stats;
+}
+
+// The temporary folder can be on another file system.
+static void moveFile(const QString &from, const QString &to)
+{
+    QFile(to).remove();
+    if (QFile::rename(from, to)) {
+        return;
+    }
+
+    if (!QFile::copy(from, to)) {
+        throw QString("Failed to write a file: '%1'.").arg(to);
+    }
+    QFile(from).remove();
+}
+
+static bool isGzipFile(const QString &path)
+{
+    QFile file(path);
+    if (!file.open(QFile::ReadOnly)) {
+        return false;
+    }
+
+    const QByteArray header = file.read(2);
+    return header.size() == 2 && quint8(header[0]) == 0x1f && quint8(header[1]) == 0x8b;
+}
+
+Compressor::Stats Compressor::zipBestOf(Level lvl, const QString &inFile, const QString &outFile,
+                                        bool isParallel) const
+{
+    struct Candidate
+    {
+        Type type;
+        QString inFile;
+        QString outFile;
+        Stats stats;
+        qint64 size = -1;
+    };
+
+    // Each compressor gets its own copy, because zip() removes the input file.
+    // Copies are kept out of the watched folders and have the original name,
+    // since 7za stores it in the gzip header.
+    QTemporaryDir dir;
+    if (!dir.isValid()) {
+        throw QString("Failed to create a temporary folder.");
+    }
+
+    const QString fileName = QFileInfo(inFile).fileName();
+    QVector<Candidate> candidates;
+    for (const Type type : raceCompressors()) {
+        const QString subDir = dir.path() + "/" + Compressor(type).name();
+        if (!QDir().mkpath(subDir)) {
+            throw QString("Failed to create a folder: '%1'.").arg(subDir);
+        }
+
+        Candidate c;
+        c.type = type;
+        c.inFile = subDir + "/" + fileName;
+        c.outFile = c.inFile + "z";
+        if (!QFile::copy(inFile, c.inFile)) {
+            throw QString("Failed to write a file: '%1'.").arg(c.inFile);
+        }
+        candidates << c;
+    }
+
+    const auto run = [lvl](Candidate &c){
+        try {
+            c.stats = Compressor(c.type).zip(lvl, c.inFile, c.outFile);
+            if (isGzipFile(c.outFile)) {
+                c.size = QFile(c.outFile).size();
+            }
+        } catch (...) {
+            // other compressors can still succeed
+            QFile(c.inFile).remove();
+        }
+    };
+
+    if (isParallel) {
+        QtConcurrent::blockingMap(candidates, run);
+    } else {
+        for (Candidate &c : candidates) {
+            run(c);
+        }
+    }
+
+    const Candidate *best = nullptr;
+    for (const Candidate &c : candidates) {
+        if (c.size > 0 && (!best || c.size < best->size)) {
+            best = &c;
+        }
+    }
+
+    for (const Candidate &c : candidates) {
+        if (&c != best) {
+            QFile(c.outFile).remove();
+        }
+    }
+
+    if (!best) {
+        throw QString("Failed to compress a file: '%1'.").arg(inFile);
+    }
+
+    moveFile(best->outFile, outFile);
+    QFile(inFile).remove();
+
+    return best->stats;
 }
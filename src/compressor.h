@@ -22,12 +22,19 @@
 
 #pragma once
 
-#include <QString>
+#include <QStringList>
+#include <QVector>
+
+class QThreadPool;
 
 namespace CompressorName
 {
     extern const QString SevenZip;
     extern const QString Zopfli;
+    extern const QString Deflate;
+    extern const QString BestOf;
+    extern const QString Brotli;
+    extern const QString Zstd;
 }
 
 class Compressor
@@ -38,6 +45,12 @@ public:
         None,
         SevenZip,
         Zopfli,
+        // built-in gzip encoder
+        Deflate,
+        // runs all available gzip compressors and keeps the smallest output
+        BestOf,
+        Brotli,
+        Zstd,
     };
 
     enum Level
@@ -49,19 +62,72 @@ public:
         Ultra,
     };
 
+    // Extra info about a compression.
+    struct Stats
+    {
+        // The compressor that produced the output.
+        Type type = None;
+        // Built-in Zopfli only.
+        int iterations = 0;
+        // Bytes saved compared to the first pass of the built-in Zopfli.
+        qint64 gain = 0;
+    };
+
     Compressor(Type t) : m_type(t) {}
     static Compressor fromName(const QString &aname) noexcept;
 
     bool isAvailable() const;
     QString levelToString(Level v) const noexcept;
     QString name() const noexcept;
+    // Appended to an SVG file name.
+    QString outputSuffix() const noexcept;
+    // Same as above, but for a copy that is kept next to the SVG file.
+    QString sidecarSuffix() const noexcept;
     Type type() const noexcept
     { return m_type; }
 
-    void zip(Level lvl, const QString &inFile, const QString &outFile) const;
+    // Zstd only.
+    void setDictionary(const QString &path)
+    { m_dictionary = path; }
+
+    // BestOf only. All available gzip compressors are used when empty.
+    void setCandidates(const QVector<Type> &list)
+    { m_candidates = list; }
+
+    // Compressors that BestOf can choose from.
+    static QVector<Type> gzipCompressors();
+
+    // A large file would keep a single core busy long after other files are done,
+    // so gzip inputs larger than `threshold` are split into blocks, which are deflated
+    // by the selected compressor on idle threads of the pool. Zero disables it.
+    //
+    // Only the built-in gzip and Zopfli encoders support it.
+    void setBlockMode(qint64 threshold, QThreadPool *pool)
+    { m_blockThreshold = threshold; m_blockPool = pool; }
+    static bool isBlockModeAvailable();
+
+    // BestOf runs compressors in parallel when `isParallel` is set.
+    Stats zip(Level lvl, const QString &inFile, const QString &outFile,
+              bool isParallel = false) const;
     static void unzip(const QString &inFile, const QString &outFile);
 
+private:
+    int deflateLevel(Level v) const noexcept;
+    int zopfliIterations(Level v) const noexcept;
+    QStringList brotliArgs(Level v) const noexcept;
+    QStringList zstdArgs(Level v) const noexcept;
+    QVector<Type> raceCompressors() const;
+    QVector<Type> blockCompressors() const;
+    Stats zipBlocks(Level lvl, const QVector<Type> &types, const QString &inFile,
+                    const QString &outFile) const;
+    Stats zipBestOf(Level lvl, const QString &inFile, const QString &outFile,
+                    bool isParallel) const;
+
 private:
     Type m_type = None;
+    QString m_dictionary;
+    QVector<Type> m_candidates;
+    qint64 m_blockThreshold = 0;
+    QThreadPool *m_blockPool = nullptr;
 };
 
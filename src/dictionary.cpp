@@ -0,0 +1,97 @@
+/****************************************************************************
+**
+** SVG Cleaner could help you to clean up your SVG files
+** from unnecessary data.
+** Copyright (C) 2012-2018 Evgeniy Reizner
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License along
+** with this program; if not, write to the Free Software Foundation, Inc.,
+** 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+**
+****************************************************************************/
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QFileInfo>
+#include <QStandardPaths>
+#include <QTemporaryDir>
+
+#include "process.h"
+#include "dictionary.h"
+
+// zstd recommends about a hundred times more samples than the dictionary size.
+static const int SampleSize = 2000;
+static const int MeasureSize = 200;
+static const int MaxDictSize = 112640; // zstd default, 110KiB
+
+QString Dictionary::filePath()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/svg.zstd-dict";
+}
+
+// Files are picked evenly, so a sample covers all parts of the tree.
+QStringList Dictionary::sampleFiles(const QStringList &files)
+{
+    if (files.size() <= SampleSize) {
+        return files;
+    }
+
+    QStringList sample;
+    for (int i = 0; i < SampleSize; ++i) {
+        sample << files.at(i * files.size() / SampleSize);
+    }
+    return sample;
+}
+
+Dictionary::Report Dictionary::train(const QStringList &files, Compressor::Level lvl)
+{
+    const QString zstd = Compressor(Compressor::Zstd).name();
+
+    // Samples are copied to a temp folder, because thousands of paths
+    // could exceed the command line length limit.
+    QTemporaryDir dir;
+    if (!dir.isValid()) {
+        throw QCoreApplication::translate("Dictionary", "Failed to create a temp folder.");
+    }
+
+    for (int i = 0; i < files.size(); ++i) {
+        QFile::copy(files.at(i), QString("%1/%2.svg").arg(dir.path()).arg(i));
+    }
+
+    const QString dictPath = filePath();
+    QDir().mkpath(QFileInfo(dictPath).absolutePath());
+
+    Process::run(zstd, { "-q", "-f", "--train", "-r", dir.path(),
+                         QString("--maxdict=%1").arg(MaxDictSize), "-o", dictPath }, 600000);
+
+    Report report;
+    report.dictSize = QFileInfo(dictPath).size();
+
+    const QStringList lvlArgs = Compressor(Compressor::Zstd).levelToString(lvl).split(' ');
+    const int step = qMax(1, files.size() / MeasureSize);
+    for (int i = 0; i < files.size(); i += step) {
+        const QString path = QString("%1/%2.svg").arg(dir.path()).arg(i);
+        if (!QFile::exists(path)) {
+            continue;
+        }
+
+        report.files++;
+        report.plainSize += QFileInfo(path).size();
+        report.withoutDict += Process::run(zstd, QStringList() << "-q" << "-c" << lvlArgs
+                                                               << path).size();
+        report.withDict += Process::run(zstd, QStringList() << "-q" << "-c" << lvlArgs
+                                                            << "-D" << dictPath << path).size();
+    }
+
+    return report;
+}
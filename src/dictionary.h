@@ -0,0 +1,49 @@
+/****************************************************************************
+**
+** SVG Cleaner could help you to clean up your SVG files
+** from unnecessary data.
+** Copyright (C) 2012-2018 Evgeniy Reizner
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License along
+** with this program; if not, write to the Free Software Foundation, Inc.,
+** 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+**
+****************************************************************************/
+
+#pragma once
+
+#include <QStringList>
+
+#include "compressor.h"
+
+// A zstd dictionary trained on cleaned files of the tree.
+//
+// Small files are mostly boilerplate, which a dictionary stores only once.
+namespace Dictionary
+{
+    struct Report
+    {
+        qint64 dictSize = 0;
+        // Measured on a part of the sample.
+        int files = 0;
+        qint64 plainSize = 0;
+        qint64 withoutDict = 0;
+        qint64 withDict = 0;
+    };
+
+    QString filePath();
+    QStringList sampleFiles(const QStringList &files);
+
+    // Throws a QString on error.
+    Report train(const QStringList &files, Compressor::Level lvl);
+}
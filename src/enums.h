@@ -30,6 +30,8 @@ enum class Status
     Ok,
     Warning,
     Error,
+    // Cleaning saved too little, so the original file was kept.
+    Unchanged,
 };
 
 namespace Cleaner
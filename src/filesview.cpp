@@ -21,9 +21,10 @@
 ****************************************************************************/
 
 #include <QDropEvent>
+#include <QHeaderView>
 #include <QMimeData>
-#include <QFileInfo>
-#include <QMessageBox>
+#include <QScrollBar>
+#include <QTimer>
 
 #include "filesview.h"
 
@@ -31,95 +32,161 @@ FilesView::FilesView(QWidget *parent)
     : QTreeView(parent)
 {
     setAcceptDrops(true);
-    installEventFilter(this);
-    viewport()->installEventFilter(this);
+
+    connect(verticalScrollBar(), &QScrollBar::valueChanged, this, &FilesView::scheduleFetch);
+    connect(this, &QTreeView::expanded, this, &FilesView::scheduleFetch);
 }
 
-bool FilesView::isReadOnly() const
+// Unlike expandAll(), which lays out every fetched row, we expand folders
+// in breadth-first order and stop after `maxRows` rows.
+void FilesView::expandFetched(int maxRows)
 {
-    return m_readOnly;
+    if (!model()) {
+        return;
+    }
+
+    QVector<QModelIndex> queue = { QModelIndex() };
+    for (int i = 0; i < queue.size() && maxRows > 0; ++i) {
+        const QModelIndex parent = queue.at(i);
+        const int rows = model()->rowCount(parent);
+        for (int row = 0; row < rows && maxRows > 0; ++row, --maxRows) {
+            const QModelIndex idx = model()->index(row, 0, parent);
+            if (model()->hasChildren(idx)) {
+                setExpanded(idx, true);
+                queue << idx;
+            }
+        }
+    }
 }
 
-void FilesView::setReadOnly(bool flag)
+void FilesView::updateGeometries()
 {
-    m_readOnly = flag;
+    QTreeView::updateGeometries();
+    scheduleFetch();
 }
 
-void FilesView::dragEnterEvent(QDragEnterEvent *event)
+// Fetching changes the layout, so it's done once per event loop iteration.
+void FilesView::scheduleFetch()
 {
-    if (!isReadOnly()) {
-        event->accept();
+    if (m_isFetchScheduled) {
+        return;
     }
+
+    m_isFetchScheduled = true;
+    QTimer::singleShot(0, this, [this](){
+        m_isFetchScheduled = false;
+        fetchVisible();
+    });
 }
 
-void FilesView::dragMoveEvent(QDragMoveEvent *event)
+// QTreeView fetches more rows only for the parents of the last row in the view,
+// so a partly fetched folder followed by siblings would never be fetched.
+// Instead, we fetch each folder whose last fetched row is visible.
+void FilesView::fetchVisible()
 {
-    if (!isReadOnly()) {
-        event->accept();
+    if (!model()) {
+        return;
+    }
+
+    const QRect rect = viewport()->rect();
+    QModelIndex idx = indexAt(rect.topLeft());
+    while (idx.isValid() && visualRect(idx).top() <= rect.bottom()) {
+        const QModelIndex parent = idx.parent();
+        if (   idx.row() == model()->rowCount(parent) - 1
+            && model()->canFetchMore(parent)) {
+            model()->fetchMore(parent);
+        }
+
+        idx = indexBelow(idx);
     }
 }
 
-void FilesView::dropEvent(QDropEvent *event)
+void FilesView::setFitColumns(const QVector<int> &columns)
 {
-    const QMimeData *mime = event->mimeData();
-    if (!mime->hasUrls()) {
-        event->ignore();
+    m_fitColumns = columns;
+    for (int column : columns) {
+        header()->setSectionResizeMode(column, QHeaderView::Interactive);
+        resizeColumnToContents(column);
+    }
+}
+
+// QHeaderView::ResizeToContents rescans all visible rows on each model change,
+// which is too slow while results are arriving. Instead, we only grow
+// the columns using the changed rows.
+void FilesView::fitColumns(const QModelIndex &parent, int first, int last)
+{
+    if (m_fitColumns.isEmpty()) {
         return;
     }
 
-    for (const QUrl &url : mime->urls()) {
-        if (!url.isLocalFile()) {
-            continue;
+    const QStyleOptionViewItem opt = viewOptions();
+    for (int column : m_fitColumns) {
+        const int currWidth = header()->sectionSize(column);
+        int width = currWidth;
+        for (int row = first; row <= last; ++row) {
+            const QModelIndex idx = model()->index(row, column, parent);
+            width = qMax(width, itemDelegate(idx)->sizeHint(opt, idx).width());
         }
 
-        QString path = url.toLocalFile();
-        QFileInfo fi = QFileInfo(path);
-        if (fi.isSymLink()) {
-            continue;
+        if (width != currWidth) {
+            header()->resizeSection(column, width);
         }
+    }
+}
 
-        if (fi.isDir()) {
-            emit folderDropped(path);
-        } else if (fi.isFile()) {
-            QString suffix = QFileInfo(path).suffix().toLower();
-            if (suffix == "svg" || suffix == "svgz") {
-                emit fileDropped(path);
-            } else {
-                // TODO: show only once
-                QMessageBox::warning(this, tr("Warning"),
-                                     tr("You can drop only svg(z) files or folders."));
-            }
-        }
+void FilesView::dataChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight,
+                            const QVector<int> &roles)
+{
+    QTreeView::dataChanged(topLeft, bottomRight, roles);
+    fitColumns(topLeft.parent(), topLeft.row(), bottomRight.row());
+}
+
+void FilesView::rowsInserted(const QModelIndex &parent, int start, int end)
+{
+    QTreeView::rowsInserted(parent, start, end);
+    fitColumns(parent, start, end);
+}
+
+void FilesView::reset()
+{
+    QTreeView::reset();
+
+    // the model is empty or was reloaded, so we can start from scratch
+    for (int column : m_fitColumns) {
+        resizeColumnToContents(column);
     }
+}
 
-    event->acceptProposedAction();
+void FilesView::dragEnterEvent(QDragEnterEvent *event)
+{
+    event->accept();
 }
 
-bool FilesView::eventFilter(QObject *obj, QEvent *event)
+void FilesView::dragMoveEvent(QDragMoveEvent *event)
 {
-    if (isReadOnly()) {
-        // ignore mouse and keyboard events in readonly mode
-        if (obj == viewport() && isReadOnly()) {
-            switch (event->type()) {
-                case QEvent::MouseButtonPress :
-                case QEvent::MouseButtonRelease :
-                case QEvent::MouseButtonDblClick :
-                case QEvent::ToolTip :
-                case QEvent::ContextMenu : {
-                    return true;
-                }
-                default: break;
-            }
-        } else if (obj == this && isReadOnly()) {
-            switch (event->type()) {
-                case QEvent::KeyPress :
-                case QEvent::KeyRelease : {
-                    return true;
-                }
-                default: break;
-            }
+    event->accept();
+}
+
+void FilesView::dropEvent(QDropEvent *event)
+{
+    const QMimeData *mime = event->mimeData();
+    if (!mime->hasUrls()) {
+        event->ignore();
+        return;
+    }
+
+    // All paths are passed at once, so they can be added in a single pass.
+    // Symlinks and unsupported files are reported by the receiver.
+    QStringList paths;
+    for (const QUrl &url : mime->urls()) {
+        if (url.isLocalFile()) {
+            paths << url.toLocalFile();
         }
     }
 
-    return QTreeView::eventFilter(obj, event);
+    if (!paths.isEmpty()) {
+        emit pathsDropped(paths);
+    }
+
+    event->acceptProposedAction();
 }
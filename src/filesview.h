@@ -31,19 +31,28 @@ class FilesView : public QTreeView
 public:
     explicit FilesView(QWidget *parent = nullptr);
 
-    bool isReadOnly() const;
-    void setReadOnly(bool flag);
+    void expandFetched(int maxRows = 1000);
+    void setFitColumns(const QVector<int> &columns);
 
 signals:
-    void folderDropped(QString);
-    void fileDropped(QString);
+    void pathsDropped(QStringList);
 
 protected:
     void dragEnterEvent(QDragEnterEvent *event);
     void dragMoveEvent(QDragMoveEvent *event);
     void dropEvent(QDropEvent *event);
-    bool eventFilter(QObject *obj, QEvent *event);
+    void dataChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight,
+                     const QVector<int> &roles = QVector<int>());
+    void rowsInserted(const QModelIndex &parent, int start, int end);
+    void reset();
+    void updateGeometries();
 
 private:
-    bool m_readOnly = false;
+    void fitColumns(const QModelIndex &parent, int first, int last);
+    void scheduleFetch();
+    void fetchVisible();
+
+private:
+    QVector<int> m_fitColumns;
+    bool m_isFetchScheduled = false;
 };
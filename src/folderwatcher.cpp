@@ -0,0 +1,322 @@
+/****************************************************************************
+**
+** SVG Cleaner could help you to clean up your SVG files
+** from unnecessary data.
+** Copyright (C) 2012-2018 Evgeniy Reizner
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License along
+** with this program; if not, write to the Free Software Foundation, Inc.,
+** 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+**
+****************************************************************************/
+
+#include <QDateTime>
+#include <QDir>
+#include <QDirIterator>
+#include <QFileSystemWatcher>
+#include <QTimer>
+
+#include "folderwatcher.h"
+
+static const int DebounceInterval = 500;
+// a continuous stream of events is still reported from time to time
+static const int MaxDebounceWait = 2000;
+static const int StabilityInterval = 1000;
+static const int PollInterval = 5000;
+// own writes that were not seen by the stability check are forgotten after this time
+static const int OwnWriteTimeout = 30000;
+
+static qint64 lastModified(const QString &path)
+{
+    return QFileInfo(path).lastModified().toMSecsSinceEpoch();
+}
+
+// Folder mtime changes only when its entries are added or removed,
+// so files rewritten in place are compared by their sizes and mtimes.
+static quint64 dirSignature(const QString &dir)
+{
+    quint64 signature = quint64(lastModified(dir));
+    for (const QFileInfo &fi : QDir(dir).entryInfoList({ "*.svg", "*.svgz" }, QDir::Files)) {
+        const quint64 time = quint64(fi.lastModified().toMSecsSinceEpoch());
+        signature = signature * 31 + (time ^ (quint64(fi.size()) << 20));
+    }
+    return signature;
+}
+
+static bool isSubPath(const QString &path, const QString &root)
+{
+    return path == root || path.startsWith(root + '/');
+}
+
+FolderWatcher::FolderWatcher(QObject *parent)
+    : QObject(parent)
+    , m_watcher(new QFileSystemWatcher(this))
+    , m_debounceTimer(new QTimer(this))
+    , m_stabilityTimer(new QTimer(this))
+    , m_pollTimer(new QTimer(this))
+{
+    m_debounceTimer->setSingleShot(true);
+    m_debounceTimer->setInterval(DebounceInterval);
+    m_stabilityTimer->setInterval(StabilityInterval);
+    m_pollTimer->setInterval(PollInterval);
+
+    connect(m_watcher, &QFileSystemWatcher::directoryChanged,
+            this, &FolderWatcher::onDirectoryChanged);
+    connect(m_debounceTimer, &QTimer::timeout, this, &FolderWatcher::processChanges);
+    connect(m_stabilityTimer, &QTimer::timeout, this, &FolderWatcher::checkStability);
+    connect(m_pollTimer, &QTimer::timeout, this, &FolderWatcher::poll);
+}
+
+void FolderWatcher::addFolder(const QString &path)
+{
+    const QString root = QDir::cleanPath(path);
+    if (m_roots.contains(root)) {
+        return;
+    }
+
+    m_roots << root;
+    watchTree(root);
+}
+
+void FolderWatcher::removeFolder(const QString &path)
+{
+    const QString root = QDir::cleanPath(path);
+    if (m_roots.removeOne(root)) {
+        unwatchTree(root);
+    }
+}
+
+bool FolderWatcher::isWatched(const QString &path) const
+{
+    return m_roots.contains(QDir::cleanPath(path));
+}
+
+QStringList FolderWatcher::folders() const
+{
+    return m_roots;
+}
+
+bool FolderWatcher::isEmpty() const
+{
+    return m_roots.isEmpty();
+}
+
+void FolderWatcher::clear()
+{
+    const QStringList roots = m_roots;
+    for (const QString &root : roots) {
+        removeFolder(root);
+    }
+    m_ownWrites.clear();
+}
+
+void FolderWatcher::waitUntilStable(const QStringList &files)
+{
+    for (const QString &path : files) {
+        // a new change restarts the waiting
+        m_pendingFiles.insert(path, FileState());
+    }
+
+    if (!m_pendingFiles.isEmpty() && !m_stabilityTimer->isActive()) {
+        m_stabilityTimer->start();
+    }
+}
+
+void FolderWatcher::ignoreWrite(const QString &path)
+{
+    if (!isInsideRoots(path)) {
+        return;
+    }
+
+    OwnWrite write;
+    write.lastModified = lastModified(path);
+    write.writtenAt = QDateTime::currentMSecsSinceEpoch();
+    m_ownWrites.insert(path, write);
+
+    pruneOwnWrites();
+}
+
+void FolderWatcher::watchTree(const QString &path)
+{
+    QStringList dirs;
+    if (!m_dirs.contains(path)) {
+        dirs << path;
+    }
+
+    QDirIterator it(path, QDir::Dirs | QDir::NoDotAndDotDot | QDir::NoSymLinks,
+                    QDirIterator::Subdirectories);
+    while (it.hasNext()) {
+        const QString dir = it.next();
+        if (!m_dirs.contains(dir)) {
+            dirs << dir;
+        }
+    }
+
+    if (dirs.isEmpty()) {
+        return;
+    }
+
+    for (const QString &dir : dirs) {
+        m_dirs.insert(dir);
+    }
+
+    // Each folder is a separate inotify watch, and their number is limited by the system.
+    const QStringList failed = m_watcher->addPaths(dirs);
+    for (const QString &dir : failed) {
+        m_polledDirs.insert(dir, dirSignature(dir));
+    }
+
+    if (!m_polledDirs.isEmpty() && !m_pollTimer->isActive()) {
+        m_pollTimer->start();
+    }
+}
+
+void FolderWatcher::unwatchTree(const QString &path)
+{
+    QStringList dirs;
+    for (const QString &dir : m_dirs) {
+        // roots can be nested
+        if (isSubPath(dir, path) && !isInsideRoots(dir)) {
+            dirs << dir;
+        }
+    }
+
+    for (const QString &dir : dirs) {
+        m_dirs.remove(dir);
+        m_polledDirs.remove(dir);
+        m_changedDirs.remove(dir);
+    }
+
+    m_watcher->removePaths(m_watcher->directories().toSet().intersect(dirs.toSet()).toList());
+
+    if (m_polledDirs.isEmpty()) {
+        m_pollTimer->stop();
+    }
+}
+
+bool FolderWatcher::isInsideRoots(const QString &path) const
+{
+    for (const QString &root : m_roots) {
+        if (isSubPath(path, root)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void FolderWatcher::onDirectoryChanged(const QString &path)
+{
+    if (m_changedDirs.isEmpty()) {
+        m_changesTimer.start();
+    }
+    m_changedDirs.insert(path);
+
+    // wait until a burst of events is over, but no longer than MaxDebounceWait
+    const qint64 left = MaxDebounceWait - m_changesTimer.elapsed();
+    m_debounceTimer->start(int(qBound<qint64>(0, left, DebounceInterval)));
+}
+
+void FolderWatcher::processChanges()
+{
+    const QStringList dirs = m_changedDirs.toList();
+    m_changedDirs.clear();
+
+    for (const QString &dir : dirs) {
+        if (!QFileInfo(dir).isDir()) {
+            m_dirs.remove(dir);
+            m_polledDirs.remove(dir);
+            continue;
+        }
+
+        // Only direct subfolders can be new here.
+        for (const QFileInfo &fi : QDir(dir).entryInfoList(QDir::Dirs | QDir::NoDotAndDotDot
+                                                           | QDir::NoSymLinks)) {
+            if (!m_dirs.contains(fi.absoluteFilePath())) {
+                watchTree(fi.absoluteFilePath());
+            }
+        }
+    }
+
+    emit foldersChanged(dirs);
+}
+
+void FolderWatcher::checkStability()
+{
+    QStringList ready;
+    for (auto it = m_pendingFiles.begin(); it != m_pendingFiles.end();) {
+        const QFileInfo fi(it.key());
+        if (!fi.isFile()) {
+            it = m_pendingFiles.erase(it);
+            continue;
+        }
+
+        FileState state;
+        state.size = fi.size();
+        state.lastModified = fi.lastModified().toMSecsSinceEpoch();
+
+        if (state.size != it->size || state.lastModified != it->lastModified) {
+            *it = state;
+            ++it;
+            continue;
+        }
+
+        const auto own = m_ownWrites.find(it.key());
+        if (own != m_ownWrites.end() && own->lastModified == state.lastModified) {
+            m_ownWrites.erase(own);
+        } else {
+            ready << it.key();
+        }
+
+        it = m_pendingFiles.erase(it);
+    }
+
+    if (m_pendingFiles.isEmpty()) {
+        m_stabilityTimer->stop();
+    }
+
+    pruneOwnWrites();
+
+    if (!ready.isEmpty()) {
+        emit filesReady(ready);
+    }
+}
+
+void FolderWatcher::poll()
+{
+    for (auto it = m_polledDirs.begin(); it != m_polledDirs.end(); ++it) {
+        const quint64 signature = dirSignature(it.key());
+        if (signature != *it) {
+            *it = signature;
+            onDirectoryChanged(it.key());
+        }
+    }
+}
+
+// Files overwritten in place may be not reported by folder events,
+// so their entries would never be matched by checkStability().
+void FolderWatcher::pruneOwnWrites()
+{
+    if (m_pruneTimer.isValid() && m_pruneTimer.elapsed() < OwnWriteTimeout) {
+        return;
+    }
+    m_pruneTimer.start();
+
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    for (auto it = m_ownWrites.begin(); it != m_ownWrites.end();) {
+        if (now - it->writtenAt > OwnWriteTimeout) {
+            it = m_ownWrites.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
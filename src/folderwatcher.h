@@ -0,0 +1,100 @@
+/****************************************************************************
+**
+** SVG Cleaner could help you to clean up your SVG files
+** from unnecessary data.
+** Copyright (C) 2012-2018 Evgeniy Reizner
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License along
+** with this program; if not, write to the Free Software Foundation, Inc.,
+** 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+**
+****************************************************************************/
+
+#pragma once
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QObject>
+#include <QSet>
+#include <QStringList>
+
+class QFileSystemWatcher;
+class QTimer;
+
+// Watches folders for new and changed SVG files.
+//
+// Events are debounced and only the changed folders are reported, without their subfolders.
+// Files are reported as ready only after they stop changing, so half-written files are skipped.
+// When the system limit of watches is reached, the rest of folders are polled
+// and compared by the sizes and mtimes of their SVG files.
+class FolderWatcher : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit FolderWatcher(QObject *parent = nullptr);
+
+    void addFolder(const QString &path);
+    void removeFolder(const QString &path);
+    bool isWatched(const QString &path) const;
+    QStringList folders() const;
+    bool isEmpty() const;
+    void clear();
+
+    void waitUntilStable(const QStringList &files);
+    // Files written by the cleaner itself are not reported.
+    void ignoreWrite(const QString &path);
+
+signals:
+    void foldersChanged(const QStringList &paths);
+    void filesReady(const QStringList &paths);
+
+private:
+    struct FileState
+    {
+        qint64 size = -1;
+        qint64 lastModified = -1;
+    };
+
+    struct OwnWrite
+    {
+        qint64 lastModified = -1;
+        qint64 writtenAt = -1;
+    };
+
+    void watchTree(const QString &path);
+    void unwatchTree(const QString &path);
+    bool isInsideRoots(const QString &path) const;
+    void onDirectoryChanged(const QString &path);
+    void processChanges();
+    void checkStability();
+    void poll();
+    void pruneOwnWrites();
+
+private:
+    QFileSystemWatcher * const m_watcher;
+    QTimer * const m_debounceTimer;
+    QTimer * const m_stabilityTimer;
+    QTimer * const m_pollTimer;
+
+    QStringList m_roots;
+    QSet<QString> m_dirs;
+    // Folders that could not be watched. Value is a signature of the folder and its SVG files.
+    QHash<QString, quint64> m_polledDirs;
+    QSet<QString> m_changedDirs;
+    // Started by the first event of a burst.
+    QElapsedTimer m_changesTimer;
+    QHash<QString, FileState> m_pendingFiles;
+    QHash<QString, OwnWrite> m_ownWrites;
+    QElapsedTimer m_pruneTimer;
+};
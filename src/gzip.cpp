@@ -0,0 +1,290 @@
+/****************************************************************************
+**
+** SVG Cleaner could help you to clean up your SVG files
+** from unnecessary data.
+** Copyright (C) 2012-2018 Evgeniy Reizner
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License along
+** with this program; if not, write to the Free Software Foundation, Inc.,
+** 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+**
+****************************************************************************/
+
+#include <QAtomicInt>
+#include <QCoreApplication>
+#include <QRunnable>
+#include <QSemaphore>
+#include <QThreadPool>
+#include <QVector>
+
+#if defined(WITH_LIBDEFLATE)
+#include <libdeflate.h>
+#endif
+
+#if defined(WITH_ZLIB)
+#include <zlib.h>
+#endif
+
+#include "gzip.h"
+
+bool Gzip::isAvailable() noexcept
+{
+#if defined(WITH_LIBDEFLATE) || defined(WITH_ZLIB)
+    return true;
+#else
+    return false;
+#endif
+}
+
+QString Gzip::backendName() noexcept
+{
+#if defined(WITH_LIBDEFLATE)
+    return "libdeflate";
+#elif defined(WITH_ZLIB)
+    return "zlib";
+#else
+    return QString();
+#endif
+}
+
+int Gzip::maxLevel() noexcept
+{
+#if defined(WITH_LIBDEFLATE)
+    return 12;
+#else
+    return 9;
+#endif
+}
+
+static QString errorMsg()
+{
+    return QCoreApplication::translate("Gzip", "Failed to compress a file.");
+}
+
+#if defined(WITH_LIBDEFLATE)
+
+QByteArray Gzip::compress(const QByteArray &data, int level)
+{
+    libdeflate_compressor *c = libdeflate_alloc_compressor(level);
+    if (!c) {
+        throw errorMsg();
+    }
+
+    QByteArray out;
+    out.resize(int(libdeflate_gzip_compress_bound(c, size_t(data.size()))));
+    const size_t size = libdeflate_gzip_compress(c, data.constData(), size_t(data.size()),
+                                                 out.data(), size_t(out.size()));
+    libdeflate_free_compressor(c);
+
+    if (size == 0) {
+        throw errorMsg();
+    }
+
+    out.resize(int(size));
+    return out;
+}
+
+#elif defined(WITH_ZLIB)
+
+QByteArray Gzip::compress(const QByteArray &data, int level)
+{
+    z_stream zs = {};
+    // 16 enables the gzip wrapper
+    if (deflateInit2(&zs, level, Z_DEFLATED, MAX_WBITS + 16, 9, Z_DEFAULT_STRATEGY) != Z_OK) {
+        throw errorMsg();
+    }
+
+    QByteArray out;
+    out.resize(int(deflateBound(&zs, uLong(data.size()))));
+
+    zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.constData()));
+    zs.avail_in = uInt(data.size());
+    zs.next_out = reinterpret_cast<Bytef*>(out.data());
+    zs.avail_out = uInt(out.size());
+
+    const int res = deflate(&zs, Z_FINISH);
+    const uLong size = zs.total_out;
+    deflateEnd(&zs);
+
+    if (res != Z_STREAM_END) {
+        throw errorMsg();
+    }
+
+    out.resize(int(size));
+    return out;
+}
+
+#else
+
+QByteArray Gzip::compress(const QByteArray &/*data*/, int /*level*/)
+{
+    throw errorMsg();
+}
+
+#endif
+
+bool Gzip::isParallelAvailable() noexcept
+{
+#if defined(WITH_ZLIB)
+    return true;
+#else
+    return false;
+#endif
+}
+
+#if defined(WITH_ZLIB)
+
+// Same as pigz.
+static const int BlockSize = 128 * 1024;
+static const int WindowSize = 32 * 1024;
+
+QByteArray Gzip::deflateBlock(const QByteArray &data, int start, int size, int level, bool isLast)
+{
+    z_stream zs = {};
+    if (deflateInit2(&zs, qMin(level, 9), Z_DEFLATED, -MAX_WBITS, 9, Z_DEFAULT_STRATEGY) != Z_OK) {
+        return QByteArray();
+    }
+
+    const auto bytes = reinterpret_cast<Bytef*>(const_cast<char*>(data.constData()));
+
+    // the end of the previous block, so matches can cross the block boundary
+    if (start > 0) {
+        const int dictSize = qMin(WindowSize, start);
+        deflateSetDictionary(&zs, bytes + start - dictSize, uInt(dictSize));
+    }
+
+    QByteArray out;
+    // a sync flush marker is not included into the bound
+    out.resize(int(deflateBound(&zs, uLong(size))) + 16);
+
+    zs.next_in = bytes + start;
+    zs.avail_in = uInt(size);
+    zs.next_out = reinterpret_cast<Bytef*>(out.data());
+    zs.avail_out = uInt(out.size());
+
+    const int res = deflate(&zs, isLast ? Z_FINISH : Z_SYNC_FLUSH);
+    const bool isOk = isLast ? res == Z_STREAM_END : (res == Z_OK && zs.avail_in == 0);
+    out.resize(int(zs.total_out));
+    deflateEnd(&zs);
+
+    return isOk ? out : QByteArray();
+}
+
+// Blocks are taken one by one, so a slow block doesn't hold others.
+struct BlockJob
+{
+    const QByteArray *data = nullptr;
+    const Gzip::BlockDeflater *deflater = nullptr;
+    QByteArray *blocks = nullptr;
+    int count = 0;
+    QAtomicInt next;
+    QSemaphore helpersDone;
+
+    void run()
+    {
+        forever {
+            const int idx = next.fetchAndAddOrdered(1);
+            if (idx >= count) {
+                return;
+            }
+
+            const int start = idx * BlockSize;
+            const int size = qMin(BlockSize, data->size() - start);
+            try {
+                blocks[idx] = (*deflater)(start, size, idx == count - 1);
+            } catch (...) {
+                // an empty block is reported by the caller
+            }
+        }
+    }
+};
+
+class BlockHelper : public QRunnable
+{
+public:
+    explicit BlockHelper(BlockJob *job) : m_job(job) {}
+
+    void run()
+    {
+        m_job->run();
+        m_job->helpersDone.release();
+    }
+
+private:
+    BlockJob * const m_job;
+};
+
+static void appendLE32(QByteArray &ba, quint32 value)
+{
+    for (int i = 0; i < 4; ++i) {
+        ba.append(char((value >> (i * 8)) & 0xff));
+    }
+}
+
+QByteArray Gzip::compressParallel(const QByteArray &data, const BlockDeflater &deflater,
+                                  QThreadPool *pool)
+{
+    QVector<QByteArray> blocks(qMax(1, (data.size() + BlockSize - 1) / BlockSize));
+
+    BlockJob job;
+    job.data = &data;
+    job.deflater = &deflater;
+    job.blocks = blocks.data();
+    job.count = blocks.size();
+
+    // tryStart() fails when all threads are busy, so a helper never waits for a thread
+    int helpers = 0;
+    for (int i = 1; pool && i < job.count; ++i) {
+        auto helper = new BlockHelper(&job);
+        if (!pool->tryStart(helper)) {
+            delete helper;
+            break;
+        }
+        helpers++;
+    }
+
+    job.run();
+    job.helpersDone.acquire(helpers);
+
+    // magic, deflate, no flags, no mtime, no extra flags, unix
+    QByteArray out("\x1f\x8b\x08\x00\x00\x00\x00\x00\x00\x03", 10);
+    for (const QByteArray &block : blocks) {
+        // a block is never empty, because it ends with a flush marker
+        if (block.isEmpty()) {
+            throw errorMsg();
+        }
+        out += block;
+    }
+
+    const auto bytes = reinterpret_cast<const Bytef*>(data.constData());
+    appendLE32(out, quint32(crc32(crc32(0, nullptr, 0), bytes, uInt(data.size()))));
+    appendLE32(out, quint32(data.size()));
+
+    return out;
+}
+
+#else
+
+QByteArray Gzip::deflateBlock(const QByteArray &/*data*/, int /*start*/, int /*size*/,
+                              int /*level*/, bool /*isLast*/)
+{
+    return QByteArray();
+}
+
+QByteArray Gzip::compressParallel(const QByteArray &/*data*/, const BlockDeflater &/*deflater*/,
+                                  QThreadPool */*pool*/)
+{
+    throw errorMsg();
+}
+
+#endif
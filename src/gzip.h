@@ -0,0 +1,64 @@
+/****************************************************************************
+**
+** SVG Cleaner could help you to clean up your SVG files
+** from unnecessary data.
+** Copyright (C) 2012-2018 Evgeniy Reizner
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License along
+** with this program; if not, write to the Free Software Foundation, Inc.,
+** 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+**
+****************************************************************************/
+
+#pragma once
+
+#include <functional>
+
+#include <QByteArray>
+#include <QString>
+
+class QThreadPool;
+
+// An in-process gzip encoder, so a compression doesn't need an external process
+// and a temporary file.
+//
+// It's available only when built with WITH_ZLIB or WITH_LIBDEFLATE.
+namespace Gzip
+{
+    bool isAvailable() noexcept;
+    QString backendName() noexcept;
+    int maxLevel() noexcept;
+
+    // Throws a QString on error.
+    QByteArray compress(const QByteArray &data, int level);
+
+    // Block-parallel mode for large files. Requires WITH_ZLIB.
+    bool isParallelAvailable() noexcept;
+
+    // Deflates `size` bytes of `data` from `start` into a raw deflate stream, using up to 32KiB
+    // before `start` as a dictionary. All blocks except the last one end with a sync flush,
+    // so they are byte-aligned and can be concatenated. Level is limited to 9.
+    //
+    // Returns an empty array on error.
+    QByteArray deflateBlock(const QByteArray &data, int start, int size, int level, bool isLast);
+
+    // Same arguments as above, except the data.
+    typedef std::function<QByteArray(int start, int size, bool isLast)> BlockDeflater;
+
+    // Blocks are deflated by the calling thread and by idle threads of the pool, if any,
+    // and joined into a single gzip stream. So the pool is never oversubscribed.
+    //
+    // Throws a QString on error.
+    QByteArray compressParallel(const QByteArray &data, const BlockDeflater &deflater,
+                                QThreadPool *pool);
+}
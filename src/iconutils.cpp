@@ -32,24 +32,37 @@ namespace IconUtils {
 
 QPixmap renderIcon(const QString &path, int width)
 {
+    const auto ratio = qApp->screens().first()->devicePixelRatio();
+    QPixmap pix = renderIcon(path, width, ratio);
+    // keep an old behavior for callers that don't expect a HiDPI pixmap
+    pix.setDevicePixelRatio(1.0);
+    return pix;
+}
+
+// Renders an icon with a specified logical width and pixel ratio.
+// The result has a device pixel ratio set, so it can be painted as is.
+QPixmap renderIcon(const QString &path, int width, qreal ratio)
+{
+    const QString key = QString("%1@%2x%3").arg(path).arg(width).arg(ratio);
+
     QPixmap pix;
-    if (QPixmapCache::find(path, &pix)) {
+    if (QPixmapCache::find(key, &pix)) {
         return pix;
     }
 
-    const auto ratio = qApp->screens().first()->devicePixelRatio();
-    width *= ratio;
+    const int size = qRound(width * ratio);
 
-    QIcon warnIcon(path);
+    QIcon icon(path);
 
-    QImage img(width, width, QImage::Format_ARGB32);
+    QImage img(size, size, QImage::Format_ARGB32_Premultiplied);
     img.fill(Qt::transparent);
     QPainter p(&img);
-    warnIcon.paint(&p, QRect(0, 0, width, width));
+    icon.paint(&p, QRect(0, 0, size, size));
     p.end();
 
     pix = QPixmap::fromImage(img);
-    QPixmapCache::insert(path, pix);
+    pix.setDevicePixelRatio(ratio);
+    QPixmapCache::insert(key, pix);
 
     return pix;
 }
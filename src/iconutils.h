@@ -27,4 +27,5 @@
 namespace IconUtils
 {
     QPixmap renderIcon(const QString &path, int width);
+    QPixmap renderIcon(const QString &path, int width, qreal ratio);
 }
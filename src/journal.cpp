@@ -0,0 +1,308 @@
+/****************************************************************************
+**
+** SVG Cleaner could help you to clean up your SVG files
+** from unnecessary data.
+** Copyright (C) 2012-2018 Evgeniy Reizner
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License along
+** with this program; if not, write to the Free Software Foundation, Inc.,
+** 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+**
+****************************************************************************/
+
+#include <QDir>
+#include <QFileInfo>
+#include <QSet>
+#include <QStandardPaths>
+
+#ifdef Q_OS_WIN
+#include <io.h>
+#include <qt_windows.h>
+#else
+#include <unistd.h>
+#endif
+
+#include "treemodel.h"
+#include "journal.h"
+
+static const quint32 Magic = 0x53564a4c; // SVJL
+static const quint16 Version = 1;
+
+namespace Record
+{
+    enum Type
+    {
+        Batch = 1,
+        Tasks,
+        Results,
+    };
+}
+
+static QVector<qint32> toInts(const QVector<Compressor::Type> &types)
+{
+    QVector<qint32> list;
+    for (const Compressor::Type type : types) {
+        list << qint32(type);
+    }
+    return list;
+}
+
+static QVector<Compressor::Type> fromInts(const QVector<qint32> &list)
+{
+    QVector<Compressor::Type> types;
+    for (const qint32 type : list) {
+        types << Compressor::Type(type);
+    }
+    return types;
+}
+
+static QDataStream& operator<<(QDataStream &out, const RunConfig &c)
+{
+    out << qint32(c.method) << c.outFolder << c.rootFolder << c.filePrefix << c.fileSuffix
+        << c.args << qint32(c.compressorType) << qint32(c.compressionLevel) << c.compressOnlySvgz
+        << c.isParallelZip << toInts(c.bestOfCompressors) << c.blockThreshold
+        << toInts(c.sidecars) << qint32(c.sidecarThreshold) << c.zstdDictionary
+        << c.isTransferEstimated << qint32(c.unchangedThreshold);
+    return out;
+}
+
+static QDataStream& operator>>(QDataStream &in, RunConfig &c)
+{
+    qint32 method = 0;
+    qint32 compressorType = 0;
+    qint32 compressionLevel = 0;
+    QVector<qint32> bestOfCompressors;
+    QVector<qint32> sidecars;
+    qint32 sidecarThreshold = 0;
+    qint32 unchangedThreshold = 0;
+    in >> method >> c.outFolder >> c.rootFolder >> c.filePrefix >> c.fileSuffix
+       >> c.args >> compressorType >> compressionLevel >> c.compressOnlySvgz
+       >> c.isParallelZip >> bestOfCompressors >> c.blockThreshold >> sidecars
+       >> sidecarThreshold >> c.zstdDictionary >> c.isTransferEstimated
+       >> unchangedThreshold;
+    c.bestOfCompressors = fromInts(bestOfCompressors);
+    c.sidecars = fromInts(sidecars);
+    c.sidecarThreshold = sidecarThreshold;
+    c.unchangedThreshold = unchangedThreshold;
+    c.method = AppSettings::SavingMethod(method);
+    c.compressorType = Compressor::Type(compressorType);
+    c.compressionLevel = Compressor::Level(compressionLevel);
+    return in;
+}
+
+Task::Output Journal::Result::toOutput(TreeItem *item) const
+{
+    switch (status) {
+        case Status::Ok :        return Task::Output::ok(okData, item);
+        case Status::Warning :   return Task::Output::warning(okData, msg, item);
+        case Status::Unchanged : return Task::Output::unchanged(okData, msg, item);
+        default :                return Task::Output::error(msg, item);
+    }
+}
+
+Journal::~Journal()
+{
+    m_file.close();
+}
+
+QString Journal::filePath()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/journal.dat";
+}
+
+Journal::State Journal::read()
+{
+    State state;
+
+    QFile file(filePath());
+    if (!file.open(QFile::ReadOnly)) {
+        return state;
+    }
+
+    QDataStream in(&file);
+    in.setVersion(QDataStream::Qt_5_6);
+
+    quint32 magic = 0;
+    quint16 version = 0;
+    in >> magic >> version;
+    if (magic != Magic || version != Version) {
+        return state;
+    }
+
+    // Each record is applied only when it was read completely.
+    while (!in.atEnd()) {
+        quint8 type = 0;
+        in >> type;
+
+        if (type == Record::Batch) {
+            Batch batch;
+            in >> batch.id >> batch.name >> batch.weight >> batch.isMain >> batch.config;
+            if (in.status() != QDataStream::Ok) {
+                break;
+            }
+            state.batches << batch;
+        } else if (type == Record::Tasks) {
+            qint32 batchId = 0;
+            QStringList roots;
+            QStringList files;
+            in >> batchId >> roots >> files;
+            if (in.status() != QDataStream::Ok) {
+                break;
+            }
+
+            for (Batch &batch : state.batches) {
+                if (batch.id == batchId) {
+                    for (const QString &root : roots) {
+                        if (!batch.roots.contains(root)) {
+                            batch.roots << root;
+                        }
+                    }
+                    batch.files << files;
+                    break;
+                }
+            }
+        } else if (type == Record::Results) {
+            qint32 count = 0;
+            in >> count;
+
+            QVector<QPair<QString, Result>> results;
+            for (int i = 0; i < count && in.status() == QDataStream::Ok; ++i) {
+                QString path;
+                quint8 status = 0;
+                Result res;
+                in >> path >> status >> res.okData >> res.msg;
+                res.status = Status(status);
+                results << qMakePair(path, res);
+            }
+
+            if (in.status() != QDataStream::Ok) {
+                break;
+            }
+
+            for (const auto &pair : results) {
+                state.results.insert(pair.first, pair.second);
+            }
+        } else {
+            break;
+        }
+    }
+
+    return state;
+}
+
+void Journal::remove()
+{
+    QFile::remove(filePath());
+}
+
+bool Journal::open()
+{
+    if (m_file.isOpen()) {
+        return true;
+    }
+
+    const QString path = filePath();
+    QDir().mkpath(QFileInfo(path).absolutePath());
+
+    m_file.setFileName(path);
+    if (!m_file.open(QFile::WriteOnly | QFile::Truncate)) {
+        return false;
+    }
+
+    m_stream.setDevice(&m_file);
+    m_stream.setVersion(QDataStream::Qt_5_6);
+    m_stream << Magic << Version;
+
+    return true;
+}
+
+// QFile::flush() only passes data to the OS, so it could be lost on a power loss.
+void Journal::sync()
+{
+    m_file.flush();
+#ifdef Q_OS_WIN
+    FlushFileBuffers(reinterpret_cast<HANDLE>(_get_osfhandle(m_file.handle())));
+#else
+    fsync(m_file.handle());
+#endif
+}
+
+void Journal::addBatch(const Batch &batch)
+{
+    if (!open()) {
+        return;
+    }
+
+    m_stream << quint8(Record::Batch) << batch.id << batch.name << batch.weight << batch.isMain
+             << batch.config;
+    sync();
+}
+
+void Journal::addTasks(int batchId, const QVector<Task::Config> &tasks)
+{
+    if (!m_file.isOpen()) {
+        return;
+    }
+
+    QSet<QString> roots;
+    QStringList files;
+    files.reserve(tasks.size());
+    for (const Task::Config &task : tasks) {
+        files << task.inputPath;
+
+        TreeItem *topItem = task.treeItem;
+        while (topItem->parent() && topItem->parent()->parent()) {
+            topItem = topItem->parent();
+        }
+        roots.insert(topItem->path());
+    }
+
+    m_stream << quint8(Record::Tasks) << qint32(batchId) << roots.toList() << files;
+    sync();
+}
+
+// Results are written in groups, so the file is synced once per group.
+void Journal::addResults(const QVector<Task::Output> &results)
+{
+    if (!m_file.isOpen()) {
+        return;
+    }
+
+    m_stream << quint8(Record::Results) << qint32(results.size());
+    for (const Task::Output &res : results) {
+        Task::Output::OkData okData;
+        QString msg;
+        if (res.type() == Status::Error) {
+            msg = res.errorMsg();
+        } else {
+            okData = res.okData();
+            if (res.type() == Status::Warning) {
+                msg = res.warningMsg();
+            } else if (res.type() == Status::Unchanged) {
+                msg = res.unchangedMsg();
+            }
+        }
+
+        m_stream << res.item()->path() << quint8(res.type()) << okData << msg;
+    }
+    sync();
+}
+
+void Journal::finish()
+{
+    if (m_file.isOpen()) {
+        m_file.close();
+        m_stream.setDevice(nullptr);
+    }
+    remove();
+}
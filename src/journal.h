@@ -0,0 +1,90 @@
+/****************************************************************************
+**
+** SVG Cleaner could help you to clean up your SVG files
+** from unnecessary data.
+** Copyright (C) 2012-2018 Evgeniy Reizner
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License along
+** with this program; if not, write to the Free Software Foundation, Inc.,
+** 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+**
+****************************************************************************/
+
+#pragma once
+
+#include <QDataStream>
+#include <QFile>
+#include <QHash>
+#include <QVector>
+
+#include "cleaner.h"
+#include "runconfig.h"
+
+// An append-only log of a cleaning run. It's written while results are coming,
+// so an interrupted run can be resumed after a crash.
+//
+// The file is removed when the run is finished. A partially written record at the end
+// of the file is ignored on reading.
+class Journal
+{
+public:
+    struct Batch
+    {
+        int id = 0;
+        QString name;
+        int weight = 1;
+        bool isMain = false;
+        RunConfig config;
+        // Top-level tree items of the files, so the tree can be restored.
+        QStringList roots;
+        QStringList files;
+    };
+
+    struct Result
+    {
+        Status status = Status::None;
+        Task::Output::OkData okData;
+        QString msg;
+
+        Task::Output toOutput(TreeItem *item) const;
+    };
+
+    struct State
+    {
+        QVector<Batch> batches;
+        // By input path.
+        QHash<QString, Result> results;
+    };
+
+    Journal() = default;
+    ~Journal();
+
+    static QString filePath();
+    static State read();
+    static void remove();
+
+    void addBatch(const Batch &batch);
+    void addTasks(int batchId, const QVector<Task::Config> &tasks);
+    void addResults(const QVector<Task::Output> &results);
+    void finish();
+
+private:
+    Q_DISABLE_COPY(Journal)
+
+    bool open();
+    void sync();
+
+private:
+    QFile m_file;
+    QDataStream m_stream;
+};
@@ -24,14 +24,22 @@
 #include <QDate>
 #include <QDesktopServices>
 #include <QFileDialog>
+#include <QMenu>
 #include <QMessageBox>
+#include <QProgressDialog>
 #include <QShortcut>
-#include <QtConcurrent/QtConcurrentMap>
+#include <QThread>
+#include <QTimer>
+#include <QtConcurrent/QtConcurrentRun>
 
 #include "settings.h"
 #include "aboutdialog.h"
+#include "calibrationdialog.h"
+#include "dictionary.h"
 #include "preferences/cleaneroptions.h"
 #include "preferences/preferencesdialog.h"
+#include "session.h"
+#include "transfer.h"
 
 #include "mainwindow.h"
 #include "ui_mainwindow.h"
@@ -40,7 +48,11 @@ MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent)
     , ui(new Ui::MainWindow)
     , m_model(new TreeModel(this))
-    , m_cleaningWatcher(new QFutureWatcher<Task::Output>(this))
+    , m_proxyModel(new ResultsProxyModel(this))
+    , m_scheduler(new Scheduler(&m_results, this))
+    , m_folderWatcher(new FolderWatcher(this))
+    , m_resultsTimer(new QTimer(this))
+    , m_filterTimer(new QTimer(this))
 #ifdef WITH_CHECK_UPDATES
     , m_updater(new Updater(this))
 #endif
@@ -68,6 +80,10 @@ MainWindow::MainWindow(QWidget *parent)
 
     ui->progressBar->hide();
 
+    restoreSession();
+    // ask after the window is shown
+    QTimer::singleShot(0, this, &MainWindow::resumeJournal);
+
 #ifdef WITH_CHECK_UPDATES
     connect(m_updater, &Updater::updatesFound, this, &MainWindow::onUpdatesFound);
     connect(m_updater, &Updater::noUpdates, this, &MainWindow::onNoUpdates);
@@ -80,6 +96,19 @@ MainWindow::~MainWindow()
 {
     saveSettings();
 
+    // running tasks must be finished before the results queue is destroyed
+    delete m_scheduler;
+
+    // Results of tasks that were finished during the shutdown.
+    // The tree is not updated, only the journal and the session.
+    const QVector<Task::Output> results = m_results.takeAll();
+    m_journal.addResults(results);
+    for (const Task::Output &res : results) {
+        applyResult(res);
+    }
+
+    Session::save(m_model);
+
     delete ui;
 }
 
@@ -102,6 +131,7 @@ void MainWindow::initToolBar()
 
     ui->actionAddFiles->setIcon(themeIcon("document-new"));
     ui->actionAddFolder->setIcon(themeIcon("folder-new"));
+    ui->actionRefresh->setIcon(themeIcon("view-refresh"));
     ui->actionClearTree->setIcon(themeIcon("edit-clear-list"));
     ui->actionStart->setIcon(themeIcon("media-playback-start"));
     ui->actionPause->setIcon(themeIcon("media-playback-pause"));
@@ -112,6 +142,7 @@ void MainWindow::initToolBar()
     ui->actionPause->setVisible(false);
     ui->actionStart->setEnabled(false);
     ui->actionStop->setEnabled(false);
+    ui->actionRefresh->setEnabled(false);
 
     connect(ui->actionStart, &QAction::triggered, this, &MainWindow::onStart);
     connect(ui->actionPause, &QAction::triggered, this, &MainWindow::onPause);
@@ -120,23 +151,21 @@ void MainWindow::initToolBar()
 
 void MainWindow::initTree()
 {
-    ui->treeView->setModel(m_model);
+    m_proxyModel->setTreeModel(m_model);
+    ui->treeView->setModel(m_proxyModel);
     ui->treeView->header()->setSectionResizeMode(Column::Name, QHeaderView::Stretch);
-    ui->treeView->header()->setSectionResizeMode(Column::SizeBefore, QHeaderView::ResizeToContents);
-    ui->treeView->header()->setSectionResizeMode(Column::SizeAfter, QHeaderView::ResizeToContents);
-    ui->treeView->header()->setSectionResizeMode(Column::Ratio, QHeaderView::ResizeToContents);
     ui->treeView->header()->setSectionResizeMode(Column::Status, QHeaderView::Fixed);
+    ui->treeView->setFitColumns({ Column::SizeBefore, Column::SizeAfter, Column::Ratio,
+                                  Column::TransferBefore, Column::TransferAfter,
+                                  Column::TransferRatio });
     ui->treeView->header()->setSectionsMovable(false);
 
-    connect(ui->treeView, &FilesView::fileDropped, [this](const QString &path){
-        addFile(path);
-        recalcTable();
-    });
+    setTransferColumnsVisible(AppSettings().flag(SettingKey::ShowTransferSizes));
+    ui->treeView->header()->setContextMenuPolicy(Qt::CustomContextMenu);
+    connect(ui->treeView->header(), &QHeaderView::customContextMenuRequested,
+            this, &MainWindow::onHeaderContextMenu);
 
-    connect(ui->treeView, &FilesView::folderDropped, [this](const QString &path){
-        addFolder(path);
-        recalcTable();
-    });
+    connect(ui->treeView, &FilesView::pathsDropped, this, &MainWindow::addPaths);
 
     const QString statusText = m_model->headerData(Column::Status, Qt::Horizontal).toString();
     const int sw = fontMetrics().width(statusText) * 1.4;
@@ -145,14 +174,78 @@ void MainWindow::initTree()
     ui->treeView->setItemDelegateForColumn(Column::Status, new StatusDelegate(this));
 
     connect(ui->treeView, &QTreeView::doubleClicked, this, &MainWindow::onDoubleClick);
+
+    connect(ui->treeView->selectionModel(), &QItemSelectionModel::selectionChanged,
+            this, &MainWindow::onSelectionChanged);
+
+    ui->treeView->setContextMenuPolicy(Qt::CustomContextMenu);
+    connect(ui->treeView, &QTreeView::customContextMenuRequested,
+            this, &MainWindow::onTreeContextMenu);
+
+    // keep an insertion order until the user clicks on a header
+    ui->treeView->header()->setSortIndicator(-1, Qt::AscendingOrder);
+    ui->treeView->setSortingEnabled(true);
+    connect(ui->treeView->header(), &QHeaderView::sortIndicatorChanged, [this](){
+        m_model->fetchAll();
+        ui->treeView->expandFetched();
+    });
+
+    // don't search the whole tree on each keystroke
+    m_filterTimer->setSingleShot(true);
+    m_filterTimer->setInterval(250);
+    connect(m_filterTimer, &QTimer::timeout, this, &MainWindow::onFilterChanged);
+    connect(ui->lineEditFilter, &QLineEdit::textChanged,
+            m_filterTimer, static_cast<void(QTimer::*)()>(&QTimer::start));
+    connect(ui->cmbBoxStatusFilter, static_cast<void(QComboBox::*)(int)>(&QComboBox::currentIndexChanged),
+            this, &MainWindow::onFilterChanged);
+}
+
+void MainWindow::setTransferColumnsVisible(bool flag)
+{
+    flag = flag && Transfer::isAvailable();
+    for (int column = Column::TransferBefore; column <= Column::TransferRatio; ++column) {
+        ui->treeView->setColumnHidden(column, !flag);
+    }
+}
+
+void MainWindow::onHeaderContextMenu(const QPoint &pos)
+{
+    QMenu menu;
+    QAction *transferAct = menu.addAction(tr("Show Transfer Sizes"));
+    transferAct->setCheckable(true);
+    transferAct->setChecked(!ui->treeView->isColumnHidden(Column::TransferBefore));
+    // estimates require the built-in gzip encoder
+    transferAct->setEnabled(Transfer::isAvailable());
+
+    if (menu.exec(ui->treeView->header()->mapToGlobal(pos)) == transferAct) {
+        AppSettings().setValue(SettingKey::ShowTransferSizes, transferAct->isChecked());
+        setTransferColumnsVisible(transferAct->isChecked());
+    }
+}
+
+void MainWindow::onFilterChanged()
+{
+    m_proxyModel->setStatusFilter((ResultsProxyModel::StatusFilter)ui->cmbBoxStatusFilter->currentIndex());
+    m_proxyModel->setPathFilter(ui->lineEditFilter->text());
+
+    if (m_proxyModel->hasFilter()) {
+        m_model->fetchAll();
+    }
+
+    ui->treeView->expandFetched();
 }
 
 void MainWindow::initWatcher()
 {
-    connect(m_cleaningWatcher, &QFutureWatcher<Task::Output>::resultReadyAt,
-            this, &MainWindow::onResultReadyAt);
-    connect(m_cleaningWatcher, &QFutureWatcher<Task::Output>::finished,
-            this, &MainWindow::onFinished);
+    connect(m_scheduler, &Scheduler::finished, this, &MainWindow::onFinished);
+
+    connect(m_folderWatcher, &FolderWatcher::foldersChanged, this, &MainWindow::onFoldersChanged);
+    connect(m_folderWatcher, &FolderWatcher::filesReady, this, &MainWindow::onFilesReady);
+
+    // Results are applied to the tree in batches, because updating it
+    // on each processed file is too slow for thousands of files per second.
+    m_resultsTimer->setInterval(50);
+    connect(m_resultsTimer, &QTimer::timeout, this, &MainWindow::processResults);
 }
 
 void MainWindow::loadSettings()
@@ -249,22 +342,7 @@ void MainWindow::on_actionAddFiles_triggered()
     }
 
     AppSettings().setValue(SettingKey::LastPath, diag.directory().absolutePath());
-
-    bool hasSymlink = false;
-
-    for (const QString &file : diag.selectedFiles()) {
-        if (!QFileInfo(file).isSymLink()) {
-            addFile(file);
-        } else {
-            hasSymlink = true;
-        }
-    }
-
-    if (hasSymlink) {
-        QMessageBox::warning(this, tr("Warning"), tr("Symlinks are not supported."));
-    }
-
-    recalcTable();
+    addPaths(diag.selectedFiles());
 }
 
 void MainWindow::on_actionAddFolder_triggered()
@@ -274,14 +352,8 @@ void MainWindow::on_actionAddFolder_triggered()
         return;
     }
 
-    if (QFileInfo(folder).isSymLink()) {
-        QMessageBox::warning(this, tr("Warning"), tr("Symlinks are not supported."));
-        return;
-    }
-
     AppSettings().setValue(SettingKey::LastPath, folder);
-    addFolder(folder);
-    recalcTable();
+    addPaths({ folder });
 }
 
 void MainWindow::onAddFiles()
@@ -289,6 +361,18 @@ void MainWindow::onAddFiles()
     ui->actionAddFiles->trigger();
 }
 
+void MainWindow::on_actionRefresh_triggered()
+{
+    const auto summary = m_model->refresh();
+    recalcTable();
+
+    if (summary.added || summary.removed || summary.modified) {
+        ui->lblFiles->setText(tr("%1 file(s): %2 added, %3 removed, %4 changed")
+                              .arg(m_model->fileCount()).arg(summary.added)
+                              .arg(summary.removed).arg(summary.modified));
+    }
+}
+
 void MainWindow::on_actionClearTree_triggered()
 {
     m_model->clear();
@@ -301,70 +385,137 @@ void MainWindow::setPauseBtnVisible(bool flag)
     ui->actionPause->setVisible(flag);
 }
 
+// Files can be added while cleaning is in progress,
+// but the tree structure and check states must stay the same.
+// Settings can be changed, since each batch has its own copy of them.
 void MainWindow::setEnableGui(bool flag)
 {
-    ui->actionAddFiles->setEnabled(flag);
-    ui->actionAddFolder->setEnabled(flag);
+    ui->actionRefresh->setEnabled(flag && !m_model->isEmpty());
     ui->actionClearTree->setEnabled(flag);
-    ui->actionPreferences->setEnabled(flag);
     ui->actionAbout->setEnabled(flag);
-    ui->widgetOutputFolder->setEnabled(flag);
-    ui->treeView->setReadOnly(!flag);
+    m_model->setChecksLocked(!flag);
 }
 
-void MainWindow::recalcTable()
+void MainWindow::restoreSession()
 {
-    m_model->calcFoldersStats();
-    ui->actionStart->setEnabled(!m_model->isEmpty());
-    ui->treeView->expandAll();
-    ui->lblFiles->setText(tr("%1 file(s)").arg(m_model->calcFileCount()));
+    if (!Session::restore(m_model)) {
+        return;
+    }
+
+    recalcTable();
+    checkSessionFiles();
 }
 
-void MainWindow::addFile(const QString &path)
+// Files could be changed since the last session, but checking them can take a while,
+// so it's done in background and the GUI is updated afterwards.
+// Results can't be reset while cleaning is running, so the check is repeated after it.
+void MainWindow::checkSessionFiles()
 {
-    auto res = m_model->addFile(path);
-    if (res == TreeModel::AddResult::FileExists) {
-        QMessageBox::warning(this, tr("Warning"), tr("File is already in the tree."));
+    m_isSessionCheckPending = true;
+
+    QVector<TreeItem*> items;
+    m_model->rootItem()->collectFiles(items);
+
+    QStringList paths;
+    QVector<qint64> lastModified;
+    paths.reserve(items.size());
+    lastModified.reserve(items.size());
+    for (const TreeItem *item : items) {
+        paths << item->path();
+        lastModified << item->data().lastModified;
     }
+
+    const int generation = m_model->generation();
+
+    auto watcher = new QFutureWatcher<QVector<Session::FileState>>(this);
+    connect(watcher, &QFutureWatcher<QVector<Session::FileState>>::finished,
+            [this, watcher, items, generation](){
+        watcher->deleteLater();
+
+        // the tree was cleared in the meantime
+        if (m_model->generation() != generation) {
+            m_isSessionCheckPending = false;
+            m_sessionCleanedItems.clear();
+            return;
+        }
+
+        if (m_scheduler->isRunning()) {
+            m_isSessionCheckDeferred = true;
+            return;
+        }
+
+        QVector<TreeItem*> changed;
+        for (const Session::FileState &state : watcher->result()) {
+            TreeItem *item = items.at(state.index);
+            if (   state.exists
+                && (   m_sessionCleanedItems.contains(item)
+                    || item->isOwnOutput(item->path(), state.size))) {
+                // cleaned after the restore or overwritten by the last run
+                item->setLastModified(state.lastModified);
+                continue;
+            }
+
+            item->resetCleanerData();
+            if (state.exists) {
+                item->setSizeBefore(state.size);
+                item->setLastModified(state.lastModified);
+            } else {
+                item->setStatus(Status::Error);
+                item->setStatusText(m_model->intern(tr("The file does not exist anymore.")));
+            }
+            changed << item;
+        }
+
+        m_isSessionCheckPending = false;
+        m_sessionCleanedItems.clear();
+        m_model->itemsEditFinished(changed);
+    });
+    watcher->setFuture(QtConcurrent::run(&Session::findChanged, paths, lastModified));
 }
 
-void MainWindow::addFolder(const QString &path)
+void MainWindow::recalcTable()
 {
-    auto res = m_model->addFolder(path);
-    if (res == TreeModel::AddResult::FolderExists) {
-        QMessageBox::warning(this, tr("Warning"), tr("Folder is already in the tree."));
-    } else if (res == TreeModel::AddResult::Empty) {
-        QMessageBox::warning(this, tr("Warning"), tr("The folder does not contain any SVG files."));
+    // stop watching folders that were removed from the tree
+    for (const QString &folder : m_folderWatcher->folders()) {
+        if (!m_model->findItem(folder)) {
+            m_folderWatcher->removeFolder(folder);
+        }
     }
+
+    m_proxyModel->updateIndex();
+    ui->actionStart->setEnabled(!m_model->isEmpty());
+    ui->actionRefresh->setEnabled(!m_model->isEmpty() && !m_scheduler->isRunning());
+    ui->treeView->expandFetched();
+
+    QString text = tr("%1 file(s)").arg(m_model->fileCount());
+    if (!m_folderWatcher->isEmpty()) {
+        text += ", " + tr("watching %n folder(s)", "", m_folderWatcher->folders().size());
+    }
+    ui->lblFiles->setText(text);
 }
 
-static QString genOutputPath(const QString &outFolder,
-                             const QString &rootFolder,
-                             const QString &path,
-                             AppSettings::SavingMethod method)
+static QString genOutputPath(const RunConfig &run, const QString &path)
 {
     QString outPath;
-    switch (method) {
+    switch (run.method) {
         case AppSettings::SelectFolder : {
-            outPath += outFolder;
-            if (rootFolder.isEmpty()) {
+            outPath += run.outFolder;
+            if (run.rootFolder.isEmpty()) {
                 outPath += QDir::separator();
                 outPath += QFileInfo(path).fileName();
             } else {
                 outPath += QDir::separator();
-                outPath += QDir(rootFolder).dirName();
+                outPath += QDir(run.rootFolder).dirName();
                 outPath += QDir::separator();
-                outPath += QDir(rootFolder).relativeFilePath(path);
+                outPath += QDir(run.rootFolder).relativeFilePath(path);
             }
         } break;
         case AppSettings::SameFolder : {
-            AppSettings settings;
-
             outPath += QFileInfo(path).absolutePath();
             outPath += QDir::separator();
-            outPath += settings.string(SettingKey::FilePrefix);
+            outPath += run.filePrefix;
             outPath += QFileInfo(path).completeBaseName();
-            outPath += settings.string(SettingKey::FileSuffix);
+            outPath += run.fileSuffix;
             outPath += ".svg";
         } break;
         case AppSettings::Overwrite : {
@@ -380,11 +531,28 @@ static QString genOutputPath(const QString &outFolder,
     return outPath;
 }
 
-static void genCleanData(TreeItem *root,
-                         AppSettings::SavingMethod method,
-                         const QString &outFolder,
-                         QString &rootFolder,
-                         QVector<Task::Config> &data)
+static Task::Config genTaskConfig(const RunConfig &run, TreeItem *item)
+{
+    Task::Config conf;
+    conf.inputPath = item->path();
+    conf.outputPath = genOutputPath(run, conf.inputPath);
+    conf.treeItem = item;
+    conf.args = run.args;
+    conf.compressorType = run.compressorType;
+    conf.compressionLevel = run.compressionLevel;
+    conf.compressOnlySvgz = run.compressOnlySvgz;
+    conf.isParallelZip = run.isParallelZip;
+    conf.bestOfCompressors = run.bestOfCompressors;
+    conf.blockThreshold = run.blockThreshold;
+    conf.sidecars = run.sidecars;
+    conf.sidecarThreshold = run.sidecarThreshold;
+    conf.zstdDictionary = run.zstdDictionary;
+    conf.isTransferEstimated = run.isTransferEstimated;
+    conf.unchangedThreshold = run.unchangedThreshold;
+    return conf;
+}
+
+static void genCleanData(TreeItem *root, const RunConfig &run, QVector<Task::Config> &data)
 {
     for (TreeItem *item : root->childrenList()) {
         if (!item->isEnabled() || item->checkState() != Qt::Checked) {
@@ -392,205 +560,949 @@ static void genCleanData(TreeItem *root,
         }
 
         if (item->isFolder()) {
-            if (rootFolder.isEmpty()) {
-                rootFolder = item->data().path;
-            }
-            genCleanData(item, method, outFolder, rootFolder, data);
+            genCleanData(item, run, data);
         } else {
-            Task::Config conf;
-            conf.inputPath = item->data().path;
-            conf.outputPath = genOutputPath(outFolder, rootFolder, item->data().path, method);
-            conf.treeItem = item;
-            data << conf;
+            data << genTaskConfig(run, item);
         }
     }
 }
 
-static void resetTreeData(TreeModel *m_model, TreeItem *root, bool isOverwriteMode)
+static void resetItem(TreeItem *item, bool isOverwriteMode)
+{
+    if (isOverwriteMode) {
+        // update initial file size since it changed
+        const QFileInfo fi(item->path());
+        item->setSizeBefore(fi.size());
+        item->setLastModified(fi.lastModified().toMSecsSinceEpoch());
+    }
+
+    item->resetCleanerData();
+}
+
+static void resetTreeData(TreeItem *root, bool isOverwriteMode, QVector<TreeItem*> &items)
 {
     for (TreeItem *item : root->childrenList()) {
         if (item->isFolder()) {
-            resetTreeData(m_model, item, isOverwriteMode);
+            resetTreeData(item, isOverwriteMode, items);
         } else {
-            if (isOverwriteMode) {
-                // update initial file size since it changed
-                item->setSizeBefore(QFile(item->data().path).size());
-            }
+            resetItem(item, isOverwriteMode);
+            items << item;
+        }
+    }
+}
 
-            item->resetCleanerData();
-            m_model->itemEditFinished(item);
+// We must check that same folder doesn't have files with the same names,
+// but with different extensions: svg and svgz.
+// The problem is when we unzip SVG we will get two files with the same name and
+// one of them will be overwritten. Which is bad.
+// It can only appear in a multithreaded mode.
+static QString findSvgzConflict(const QVector<Task::Config> &data)
+{
+    QSet<QString> set;
+    for (const auto &t : data) {
+        QString path = t.inputPath;
+        if (path.endsWith('z') || path.endsWith('Z')) {
+            path.chop(1);
+        }
+
+        if (set.contains(path)) {
+            return path;
         }
+        set.insert(path);
     }
+
+    return QString();
 }
 
-void MainWindow::onStart()
+void MainWindow::addPaths(const QStringList &paths)
 {
-    if (m_cleaningWatcher->isPaused()) {
-        m_cleaningWatcher->resume();
-        setPauseBtnVisible(true);
-        return;
+    const auto summary = m_model->addPaths(paths);
+    recalcTable();
+
+    // append new files to the running batch
+    if (m_scheduler->isRunning() && !m_isStopping && prepareMainBatch()) {
+        QVector<Task::Config> tasks;
+        for (TreeItem *item : summary.items) {
+            if (item->isFolder()) {
+                QVector<TreeItem*> files;
+                item->collectFiles(files);
+                for (TreeItem *file : files) {
+                    tasks << genTaskConfig(m_run, file);
+                }
+            } else {
+                tasks << genTaskConfig(m_run, item);
+            }
+        }
+        if (!tasks.isEmpty()) {
+            startTasks(m_mainBatchId, tasks);
+        }
     }
 
+    // show all problems in one message
+    QStringList msgs;
+    if (summary.duplicates > 0) {
+        msgs << tr("%n file(s) or folder(s) are already in the tree.", "", summary.duplicates);
+    }
+    if (summary.emptyFolders > 0) {
+        msgs << tr("%n folder(s) do not contain any SVG files.", "", summary.emptyFolders);
+    }
+    if (summary.symlinks > 0) {
+        msgs << tr("Symlinks are not supported. %n symlink(s) were skipped.", "", summary.symlinks);
+    }
+    if (summary.unsupported > 0) {
+        msgs << tr("You can add only svg(z) files or folders. %n file(s) were skipped.", "",
+                   summary.unsupported);
+    }
+
+    if (!msgs.isEmpty()) {
+        QMessageBox::warning(this, tr("Warning"), msgs.join("\n"));
+    }
+}
+
+// Checks the settings and takes a snapshot of them, so files added to
+// a running batch are processed the same way.
+bool MainWindow::readRunConfig(RunConfig &run)
+{
     // save a file prefix and suffix
     saveSettings();
 
     AppSettings settings;
 
-    const auto method = (AppSettings::SavingMethod)settings.integer(SettingKey::SavingMethod);
-    const QString outFolder = settings.string(SettingKey::OutputFolder);
+    run.method = (AppSettings::SavingMethod)settings.integer(SettingKey::SavingMethod);
+    run.outFolder = settings.string(SettingKey::OutputFolder);
+    run.filePrefix = settings.string(SettingKey::FilePrefix);
+    run.fileSuffix = settings.string(SettingKey::FileSuffix);
 
-    if (method == AppSettings::SelectFolder) {
-        if (outFolder.isEmpty() || !QFileInfo(outFolder).isDir() || !QFileInfo(outFolder).exists()) {
+    if (run.method == AppSettings::SelectFolder) {
+        if (run.outFolder.isEmpty() || !QFileInfo(run.outFolder).isDir()
+            || !QFileInfo(run.outFolder).exists()) {
             QMessageBox::warning(this, tr("Error"), tr("Invalid output folder."));
-            return;
+            return false;
         }
-    } else if (method == AppSettings::SameFolder) {
-        QString prefix = ui->lineEditFilePrefix->text();
-        QString suffix = ui->lineEditFileSuffix->text();
-
-        if (prefix.isEmpty() && suffix.isEmpty()) {
+    } else if (run.method == AppSettings::SameFolder) {
+        if (run.filePrefix.isEmpty() && run.fileSuffix.isEmpty()) {
             QMessageBox::warning(this, tr("Error"), tr("You must set a prefix and/or suffix."));
-            return;
+            return false;
         }
     }
 
-    Compressor::Type compressorType = Compressor::None;
-    const auto compressionLevel = (Compressor::Level)settings.integer(SettingKey::CompressionLevel);
-    const bool compressOnlySvgz = settings.flag(SettingKey::CompressOnlySvgz);
+    run.compressionLevel = (Compressor::Level)settings.integer(SettingKey::CompressionLevel);
+    run.compressOnlySvgz = settings.flag(SettingKey::CompressOnlySvgz);
     // check that selected compressor is still exists
     if (settings.flag(SettingKey::UseCompression)) {
         const auto c = Compressor::fromName(settings.string(SettingKey::Compressor));
-        compressorType = c.type();
-        if (compressorType != Compressor::None && !c.isAvailable()) {
+        run.compressorType = c.type();
+        if (run.compressorType != Compressor::None && !c.isAvailable()) {
             QMessageBox::warning(this, tr("Error"),
                                   tr("Selected compressor is not found.\n"
                                      "Change it in Preferences."));
-            return;
+            return false;
+        }
+    }
+
+    if (run.compressorType == Compressor::BestOf) {
+        const QStringList names = settings.string(SettingKey::BestOfCompressors).split(',');
+        for (const Compressor::Type type : Compressor::gzipCompressors()) {
+            const Compressor c(type);
+            if (names.contains(c.name()) && c.isAvailable()) {
+                run.bestOfCompressors << type;
+            }
+        }
+
+        if (run.bestOfCompressors.isEmpty()) {
+            QMessageBox::warning(this, tr("Error"),
+                                 tr("No compressors are selected for the best-of compression.\n"
+                                    "Change it in Preferences."));
+            return false;
+        }
+    }
+
+    if (settings.flag(SettingKey::BlockCompression) && Compressor::isBlockModeAvailable()) {
+        run.blockThreshold = qint64(settings.integer(SettingKey::BlockThreshold)) * 1024 * 1024;
+    }
+
+    if (settings.flag(SettingKey::UseCompression) && settings.flag(SettingKey::Sidecars)) {
+        const QStringList formats = settings.string(SettingKey::SidecarFormats).split(',');
+        if (formats.contains("gz")) {
+            // the selected compressor is used when it produces gzip
+            const bool isGzip = run.compressorType != Compressor::None
+                                && Compressor(run.compressorType).outputSuffix() == "z";
+            run.sidecars << (isGzip ? run.compressorType : Compressor::SevenZip);
+        }
+        if (formats.contains("br")) {
+            run.sidecars << Compressor::Brotli;
+        }
+        if (formats.contains("zst")) {
+            run.sidecars << Compressor::Zstd;
+        }
+
+        for (const Compressor::Type type : run.sidecars) {
+            if (!Compressor(type).isAvailable()) {
+                QMessageBox::warning(this, tr("Error"),
+                                     tr("Compressor '%1' is not found.\n"
+                                        "Change it in Preferences.").arg(Compressor(type).name()));
+                return false;
+            }
+        }
+
+        if (run.sidecars.isEmpty()) {
+            QMessageBox::warning(this, tr("Error"),
+                                 tr("No formats are selected for precompressed copies.\n"
+                                    "Change it in Preferences."));
+            return false;
+        }
+
+        run.sidecarThreshold = settings.integer(SettingKey::SidecarThreshold);
+    }
+
+    if (settings.flag(SettingKey::UseDictionary)) {
+        run.zstdDictionary = Dictionary::filePath();
+        if (!QFile::exists(run.zstdDictionary)) {
+            QMessageBox::warning(this, tr("Error"), tr("The zstd dictionary is not found."));
+            return false;
+        }
+    }
+
+    if (settings.flag(SettingKey::SkipUnchanged)) {
+        run.unchangedThreshold = settings.integer(SettingKey::UnchangedThreshold);
+    }
+
+    run.isTransferEstimated = settings.flag(SettingKey::ShowTransferSizes)
+                              && Transfer::isAvailable();
+
+    run.args = CleanerOptions::genArgs();
+
+    // the pool is shared by all batches
+    m_scheduler->setMaxThreadCount(settings.integer(SettingKey::Jobs));
+    run.isParallelZip = settings.integer(SettingKey::Jobs) < QThread::idealThreadCount();
+
+    return true;
+}
+
+// The main batch is started by the Start button. Added and watched files go to it too.
+bool MainWindow::hasMainBatch() const
+{
+    return m_scheduler->isRunning() && m_scheduler->hasBatch(m_mainBatchId);
+}
+
+bool MainWindow::readMainRunConfig(RunConfig &run)
+{
+    if (!readRunConfig(run)) {
+        return false;
+    }
+
+    // the output structure is relative to the first selected folder
+    for (TreeItem *item : m_model->rootItem()->childrenList()) {
+        if (item->isFolder() && item->checkState() == Qt::Checked) {
+            run.rootFolder = item->path();
+            break;
         }
     }
 
-    const QStringList args = CleanerOptions::genArgs();
+    return true;
+}
 
-    resetTreeData(m_model, m_model->rootItem(), method == AppSettings::Overwrite);
+void MainWindow::addMainBatch(const RunConfig &run)
+{
+    m_run = run;
+    m_mainBatchId = m_scheduler->addBatch(tr("Main"));
+    addJournalBatch(m_mainBatchId, tr("Main"), 1, m_run);
+}
+
+bool MainWindow::prepareMainBatch()
+{
+    if (hasMainBatch()) {
+        return true;
+    }
+
+    RunConfig run;
+    if (!readMainRunConfig(run)) {
+        return false;
+    }
+
+    addMainBatch(run);
+    return true;
+}
+
+void MainWindow::startTasks(int batchId, const QVector<Task::Config> &tasks)
+{
+    if (!m_scheduler->isRunning()) {
+        m_processedFiles = 0;
+        m_totalFiles = 0;
+
+        ui->progressBar->setValue(0);
+        ui->progressBar->show();
+
+        setEnableGui(false);
+        setPauseBtnVisible(true);
+        ui->actionStop->setEnabled(true);
+
+        m_resultsTimer->start();
+    }
+
+    m_totalFiles += tasks.size();
+    m_journal.addTasks(batchId, tasks);
+    m_scheduler->enqueue(batchId, tasks);
+
+    updateProgress();
+}
+
+// Starts a separate batch for the item with the current settings.
+// It runs alongside other batches and gets a share of the pool according to its weight.
+void MainWindow::startBatch(TreeItem *item, int weight)
+{
+    RunConfig run;
+    if (!readRunConfig(run)) {
+        return;
+    }
+
+    TreeItem *topItem = item;
+    while (topItem->parent() != m_model->rootItem()) {
+        topItem = topItem->parent();
+    }
+    if (topItem->isFolder()) {
+        run.rootFolder = topItem->path();
+    }
 
     QVector<Task::Config> data;
-    QString rootPath;
-    genCleanData(m_model->rootItem(), method, outFolder, rootPath, data);
+    if (item->isFolder()) {
+        genCleanData(item, run, data);
+    } else if (item->isEnabled() && item->checkState() == Qt::Checked) {
+        data << genTaskConfig(run, item);
+    }
 
     if (data.isEmpty()) {
         QMessageBox::warning(this, tr("Error"), tr("No files are selected."));
         return;
     }
 
-    {
-        // We must check that same folder doesn't have files with the same names,
-        // but with different extensions: svg and svgz.
-        // The problem is when we unzip SVG we will get two files with the same name and
-        // one of them will be overwritten. Which is bad.
-        // It can only appear in a multithreaded mode.
-
-        QString duplFile;
-        QSet<QString> set;
-        for (const auto &t : data) {
-            QString path = t.inputPath;
-            if (path.endsWith('z') || path.endsWith('Z')) {
-                path.chop(1);
+    const QString duplFile = findSvgzConflict(data);
+    if (!duplFile.isEmpty()) {
+        QMessageBox::warning(this, tr("Error"),
+            tr("You can't have both SVG and SVGZ files with the same name in the one dir.\n\n"
+               "%1\n%2").arg(duplFile, duplFile + "z"));
+        return;
+    }
+
+    // Queued tasks of these files are replaced by the new batch.
+    // Files that are being processed right now are run again after the current task,
+    // since the scheduler never runs two tasks for one file at once.
+    QSet<TreeItem*> items;
+    QVector<TreeItem*> changed;
+    for (const Task::Config &conf : data) {
+        items.insert(conf.treeItem);
+        resetItem(conf.treeItem, run.method == AppSettings::Overwrite);
+        changed << conf.treeItem;
+    }
+    m_totalFiles -= m_scheduler->remove(items);
+    m_model->itemsEditFinished(changed);
+
+    const int batchId = m_scheduler->addBatch(item->title(), weight);
+    addJournalBatch(batchId, item->title(), weight, run);
+    startTasks(batchId, data);
+}
+
+void MainWindow::addJournalBatch(int id, const QString &name, int weight, const RunConfig &run)
+{
+    Journal::Batch batch;
+    batch.id = id;
+    batch.name = name;
+    batch.weight = weight;
+    batch.isMain = (id == m_mainBatchId);
+    batch.config = run;
+    m_journal.addBatch(batch);
+}
+
+// Offers to continue a run that was interrupted by a crash or by quitting the app.
+void MainWindow::resumeJournal()
+{
+    const Journal::State state = Journal::read();
+
+    // files without a result or with a lost output file
+    QVector<QStringList> pending;
+    QSet<QString> pendingSet;
+    for (const Journal::Batch &batch : state.batches) {
+        QStringList files;
+        for (const QString &file : batch.files) {
+            const auto it = state.results.constFind(file);
+            if (it == state.results.constEnd()
+                || (it->status != Status::Error && !QFile::exists(it->okData.outputPath))) {
+                files << file;
+                pendingSet.insert(file);
             }
+        }
+        pending << files;
+    }
+
+    if (pendingSet.isEmpty()) {
+        Journal::remove();
+        return;
+    }
 
-            if (set.contains(path)) {
-                duplFile = path;
-                break;
+    auto btn = QMessageBox::question(this, tr("Resume?"),
+                                     tr("The previous cleaning was interrupted.\n"
+                                        "%n file(s) were not processed.\n\n"
+                                        "Resume it?", "", pendingSet.size()),
+                                     QMessageBox::Yes, QMessageBox::No);
+    if (btn != QMessageBox::Yes) {
+        Journal::remove();
+        return;
+    }
+
+    // the tree could be changed since the run was started
+    QStringList missing;
+    for (const Journal::Batch &batch : state.batches) {
+        for (const QString &root : batch.roots) {
+            if (!m_model->findItem(root) && !missing.contains(root)) {
+                missing << root;
             }
-            set.insert(path);
         }
+    }
+    if (!missing.isEmpty()) {
+        m_model->addPaths(missing);
+        recalcTable();
+    }
 
-        if (!duplFile.isEmpty()) {
-            QMessageBox::warning(this, tr("Error"),
-                tr("You can't have both SVG and SVGZ files with the same name in the one dir.\n\n"
-                   "%1\n%2").arg(duplFile, duplFile + "z"));
-            return;
+    // show results of already processed files
+    QVector<TreeItem*> changed;
+    for (auto it = state.results.constBegin(); it != state.results.constEnd(); ++it) {
+        TreeItem *item = m_model->findItem(it.key());
+        if (item && !pendingSet.contains(it.key())) {
+            applyResult(it->toOutput(item));
+            changed << item;
+        }
+    }
+    m_model->itemsEditFinished(changed);
+
+    // the pool is shared by all batches
+    AppSettings settings;
+    m_scheduler->setMaxThreadCount(settings.integer(SettingKey::Jobs));
+
+    // batches are resumed with the settings they were started with
+    for (int i = 0; i < state.batches.size(); ++i) {
+        const Journal::Batch &batch = state.batches.at(i);
+
+        QVector<Task::Config> tasks;
+        changed.clear();
+        for (const QString &file : pending.at(i)) {
+            TreeItem *item = m_model->findItem(file);
+            if (!item) {
+                continue;
+            }
+
+            resetItem(item, batch.config.method == AppSettings::Overwrite);
+            tasks << genTaskConfig(batch.config, item);
+            changed << item;
+        }
+
+        if (tasks.isEmpty()) {
+            continue;
+        }
+
+        m_model->itemsEditFinished(changed);
+
+        const int batchId = m_scheduler->addBatch(batch.name, batch.weight);
+        if (batch.isMain) {
+            m_run = batch.config;
+            m_mainBatchId = batchId;
         }
+        addJournalBatch(batchId, batch.name, batch.weight, batch.config);
+        startTasks(batchId, tasks);
     }
 
-    for (Task::Config &conf : data) {
-        conf.args = args;
-        conf.compressorType = compressorType;
-        conf.compressionLevel = compressionLevel;
-        conf.compressOnlySvgz = compressOnlySvgz;
+    if (!m_scheduler->isRunning()) {
+        m_journal.finish();
     }
+}
 
-    ui->progressBar->setValue(0);
-    ui->progressBar->setMaximum(data.size());
-    ui->progressBar->show();
+void MainWindow::updateProgress()
+{
+    if (m_isStopping) {
+        return;
+    }
 
-    setEnableGui(false);
-    setPauseBtnVisible(true);
-    ui->actionStop->setEnabled(true);
+    ui->progressBar->setMaximum(m_totalFiles);
+    ui->progressBar->setValue(m_processedFiles);
 
-    QThreadPool::globalInstance()->setMaxThreadCount(settings.integer(SettingKey::Jobs));
-    m_cleaningWatcher->setFuture(QtConcurrent::mapped(data, &Task::cleanFile));
+    const auto batches = m_scheduler->batches();
+    if (batches.size() < 2) {
+        ui->progressBar->setFormat("%p%");
+        ui->progressBar->setToolTip(QString());
+        return;
+    }
+
+    QStringList percents;
+    QStringList details;
+    for (const Scheduler::BatchInfo &batch : batches) {
+        const int percent = batch.total > 0 ? batch.processed * 100 / batch.total : 100;
+        percents << QString("%1 %2%").arg(batch.name).arg(percent);
+        details << tr("%1: %2 of %3 file(s)").arg(batch.name).arg(batch.processed).arg(batch.total);
+    }
+
+    ui->progressBar->setFormat(percents.join(" | "));
+    ui->progressBar->setToolTip(details.join("\n"));
+}
+
+void MainWindow::onStart()
+{
+    if (m_scheduler->isPaused()) {
+        m_scheduler->resume();
+        setPauseBtnVisible(true);
+        return;
+    }
+
+    // Nothing is changed until the tasks are validated,
+    // so a cancelled start keeps previous results.
+    const bool isMainBatchRunning = hasMainBatch();
+    RunConfig run = m_run;
+    if (!isMainBatchRunning && !readMainRunConfig(run)) {
+        return;
+    }
+
+    QVector<Task::Config> data;
+    genCleanData(m_model->rootItem(), run, data);
+
+    if (data.isEmpty()) {
+        QMessageBox::warning(this, tr("Error"), tr("No files are selected."));
+        return;
+    }
+
+    const QString duplFile = findSvgzConflict(data);
+    if (!duplFile.isEmpty()) {
+        QMessageBox::warning(this, tr("Error"),
+            tr("You can't have both SVG and SVGZ files with the same name in the one dir.\n\n"
+               "%1\n%2").arg(duplFile, duplFile + "z"));
+        return;
+    }
+
+    {
+        QVector<TreeItem*> items;
+        resetTreeData(m_model->rootItem(), run.method == AppSettings::Overwrite, items);
+        m_model->itemsEditFinished(items);
+    }
+
+    if (!isMainBatchRunning) {
+        addMainBatch(run);
+    }
+
+    startTasks(m_mainBatchId, data);
 }
 
 void MainWindow::onPause()
 {
     setPauseBtnVisible(false);
-    m_cleaningWatcher->pause();
+    m_scheduler->pause();
 }
 
 void MainWindow::onStop()
 {
+    m_isStopping = true;
     ui->actionStop->setEnabled(false);
     ui->progressBar->setMaximum(0); // enable wait animation
-    m_cleaningWatcher->cancel();
+    m_scheduler->cancel();
 }
 
-void MainWindow::onResultReadyAt(int idx)
+void MainWindow::processResults()
 {
-    ui->progressBar->setValue(m_cleaningWatcher->progressValue());
+    const QVector<Task::Output> results = m_results.takeAll();
+    if (results.isEmpty()) {
+        return;
+    }
+
+    m_journal.addResults(results);
+
+    QVector<TreeItem*> items;
+    items.reserve(results.size());
+
+    for (const Task::Output &res : results) {
+        applyResult(res);
+        items << res.item();
+    }
+
+    m_model->itemsEditFinished(items);
 
-    auto res = m_cleaningWatcher->resultAt(idx);
+    m_processedFiles += results.size();
+    updateProgress();
+}
 
+void MainWindow::applyResult(const Task::Output &res)
+{
     TreeItem *item = res.item();
 
+    if (m_isSessionCheckPending) {
+        m_sessionCleanedItems.insert(item);
+    }
+
     if (res.type() == Status::Error) {
         item->setStatus(Status::Error);
-        item->setStatusText(res.errorMsg());
-        m_model->itemEditFinished(item);
+        item->setStatusText(m_model->intern(res.errorMsg()));
         return;
     }
 
     auto d = res.okData();
-    item->setStatus(Status::Ok);
     item->setSizeAfter(d.outSize);
     item->setRatio(d.ratio);
     item->setOutputPath(d.outputPath);
+    item->setZipStats(d.zipStats);
+    item->setArtifacts(d.artifacts);
+    item->setTransferSizes(d.transferBefore, d.transferAfter);
+
+    if (!m_folderWatcher->isEmpty()) {
+        m_folderWatcher->ignoreWrite(d.outputPath);
+        for (const Task::Output::Artifact &artifact : d.artifacts) {
+            m_folderWatcher->ignoreWrite(artifact.path);
+        }
+    }
 
     if (res.type() == Status::Ok) {
         item->setStatus(Status::Ok);
     } else if (res.type() == Status::Warning) {
         auto wd = res.warningMsg();
         item->setStatus(Status::Warning);
-        item->setStatusText(wd);
+        item->setStatusText(m_model->intern(wd));
+    } else if (res.type() == Status::Unchanged) {
+        item->setStatus(Status::Unchanged);
+        item->setStatusText(m_model->intern(res.unchangedMsg()));
     } else {
         Q_UNREACHABLE();
     }
-
-    m_model->itemEditFinished(item);
 }
 
 void MainWindow::onFinished()
 {
-    onStop();
-    ui->progressBar->hide();
-    m_model->calcFoldersStats();
+    // files from watched folders could be added after the signal was emitted
+    if (m_scheduler->isRunning()) {
+        return;
+    }
+
+    m_resultsTimer->stop();
+    // apply results that came after the last timer tick
+    processResults();
+    m_journal.finish();
 
-    // force update, because it's not always invoked automatically
-    ui->treeView->resizeColumnToContents(Column::SizeBefore);
-    ui->treeView->resizeColumnToContents(Column::SizeAfter);
-    ui->treeView->resizeColumnToContents(Column::Ratio);
+    m_isStopping = false;
+    ui->actionStop->setEnabled(false);
+    ui->progressBar->hide();
 
     setEnableGui(true);
     setPauseBtnVisible(false);
+
+    // removed files were kept in the tree while cleaning was in progress
+    if (!m_postponedFolders.isEmpty()) {
+        const QStringList folders = m_postponedFolders.toList();
+        m_postponedFolders.clear();
+        onFoldersChanged(folders);
+    }
+
+    if (m_isSessionCheckDeferred) {
+        m_isSessionCheckDeferred = false;
+        checkSessionFiles();
+    }
+}
+
+void MainWindow::onFoldersChanged(const QStringList &folders)
+{
+    // Removing items while cleaning is in progress will invalidate task pointers.
+    const bool isRunning = m_scheduler->isRunning();
+
+    QStringList files;
+    for (const QString &folder : folders) {
+        const auto summary = m_model->refreshFolder(folder, !isRunning);
+        for (TreeItem *item : summary.changedFiles) {
+            files << item->path();
+        }
+
+        if (isRunning) {
+            m_postponedFolders.insert(folder);
+        }
+    }
+
+    recalcTable();
+    m_folderWatcher->waitUntilStable(files);
+}
+
+void MainWindow::onFilesReady(const QStringList &files)
+{
+    if (m_isStopping || m_scheduler->isPaused()) {
+        return;
+    }
+
+    // Calibration measures the CPU time of all child processes,
+    // so nothing else must be cleaned at the same time.
+    if (m_isCalibrating) {
+        m_calibrationReadyFiles << files;
+        return;
+    }
+
+    QVector<TreeItem*> items;
+    for (const QString &path : files) {
+        TreeItem *item = m_model->findItem(path);
+        if (!item || item->isFolder() || !item->isEnabled() || item->checkState() != Qt::Checked) {
+            continue;
+        }
+
+        // the file could be changed after the last folder event
+        m_model->refreshFile(QFileInfo(path), item);
+        item->resetCleanerData();
+        items << item;
+    }
+
+    if (items.isEmpty()) {
+        return;
+    }
+
+    m_model->itemsEditFinished(items);
+
+    if (!prepareMainBatch()) {
+        return;
+    }
+
+    // Files could be queued already. Ones that are being processed right now
+    // are handled by the scheduler, which runs a new task after the current one.
+    QSet<TreeItem*> itemSet;
+    QVector<Task::Config> tasks;
+    tasks.reserve(items.size());
+    for (TreeItem *item : items) {
+        itemSet.insert(item);
+        tasks << genTaskConfig(m_run, item);
+    }
+    m_totalFiles -= m_scheduler->remove(itemSet);
+
+    startTasks(m_mainBatchId, tasks);
+}
+
+void MainWindow::onTreeContextMenu(const QPoint &pos)
+{
+    TreeItem *item = m_proxyModel->itemByIndex(ui->treeView->indexAt(pos));
+    if (!item) {
+        return;
+    }
+
+    QMenu menu(this);
+
+    QAction *processAction = menu.addAction(tr("Process Next"));
+    processAction->setEnabled(m_scheduler->isRunning());
+
+    QMenu *batchMenu = menu.addMenu(tr("Clean in a New Batch"));
+    batchMenu->setEnabled(!m_isStopping);
+    QAction *lowAction = batchMenu->addAction(tr("Low Priority"));
+    QAction *normalAction = batchMenu->addAction(tr("Normal Priority"));
+    QAction *highAction = batchMenu->addAction(tr("High Priority"));
+
+    QAction *watchAction = nullptr;
+    if (item->isFolder() && item->parent() == m_model->rootItem()) {
+        watchAction = menu.addAction(tr("Watch for Changes"));
+        watchAction->setCheckable(true);
+        watchAction->setChecked(m_folderWatcher->isWatched(item->path()));
+    }
+
+    menu.addSeparator();
+    QAction *calibrateAction = menu.addAction(tr("Calibrate Compression..."));
+    calibrateAction->setEnabled(!m_scheduler->isRunning());
+
+    QMenu *dictMenu = menu.addMenu(tr("zstd Dictionary"));
+    dictMenu->setEnabled(!m_scheduler->isRunning() && Compressor(Compressor::Zstd).isAvailable());
+    QAction *trainAction = dictMenu->addAction(tr("Train on These Files..."));
+    QAction *exportAction = dictMenu->addAction(tr("Export..."));
+    exportAction->setEnabled(QFile::exists(Dictionary::filePath()));
+    QAction *useDictAction = dictMenu->addAction(tr("Use for Zstandard"));
+    useDictAction->setCheckable(true);
+    useDictAction->setEnabled(exportAction->isEnabled());
+    useDictAction->setChecked(AppSettings().flag(SettingKey::UseDictionary));
+
+    QAction *action = menu.exec(ui->treeView->viewport()->mapToGlobal(pos));
+    if (!action) {
+        return;
+    }
+
+    if (action == processAction) {
+        prioritize({ item }, true);
+    } else if (action == lowAction) {
+        startBatch(item, 1);
+    } else if (action == normalAction) {
+        startBatch(item, 2);
+    } else if (action == highAction) {
+        startBatch(item, 4);
+    } else if (action == watchAction) {
+        if (watchAction->isChecked()) {
+            m_folderWatcher->addFolder(item->path());
+        } else {
+            m_folderWatcher->removeFolder(item->path());
+        }
+        recalcTable();
+    } else if (action == calibrateAction) {
+        calibrate(item);
+    } else if (action == trainAction) {
+        trainDictionary(item);
+    } else if (action == exportAction) {
+        exportDictionary();
+    } else if (action == useDictAction) {
+        AppSettings().setValue(SettingKey::UseDictionary, useDictAction->isChecked());
+    }
+}
+
+// Uses files of the item as a sample corpus.
+void MainWindow::calibrate(TreeItem *item)
+{
+    QVector<TreeItem*> items;
+    if (item->isFolder()) {
+        item->collectFiles(items);
+    } else {
+        items << item;
+    }
+
+    QStringList files;
+    for (const TreeItem *file : items) {
+        files << file->path();
+    }
+
+    files = CalibrationDialog::sampleFiles(files);
+    if (files.isEmpty()) {
+        QMessageBox::warning(this, tr("Error"), tr("Only SVGZ files are selected."));
+        return;
+    }
+
+    m_isCalibrating = true;
+    CalibrationDialog diag(files, this);
+    diag.exec();
+    m_isCalibrating = false;
+
+    if (!m_calibrationReadyFiles.isEmpty()) {
+        QStringList ready = m_calibrationReadyFiles;
+        m_calibrationReadyFiles.clear();
+        ready.removeDuplicates();
+        onFilesReady(ready);
+    }
+}
+
+// Cleaned outputs are used when there are any, because they are what will be compressed.
+void MainWindow::trainDictionary(TreeItem *item)
+{
+    QVector<TreeItem*> items;
+    if (item->isFolder()) {
+        item->collectFiles(items);
+    } else {
+        items << item;
+    }
+
+    QStringList inputs;
+    QStringList outputs;
+    for (const TreeItem *file : items) {
+        const TreeItemData &d = file->data();
+        if (   (   d.status == Status::Ok || d.status == Status::Warning
+                || d.status == Status::Unchanged)
+            && d.outPath.endsWith(".svg", Qt::CaseInsensitive)) {
+            outputs << file->outputPath();
+        } else if (!file->name().endsWith("z", Qt::CaseInsensitive)) {
+            inputs << file->path();
+        }
+    }
+
+    const QStringList files = Dictionary::sampleFiles(outputs.isEmpty() ? inputs : outputs);
+    if (files.isEmpty()) {
+        QMessageBox::warning(this, tr("Error"), tr("Only SVGZ files are selected."));
+        return;
+    }
+
+    AppSettings settings;
+    const auto lvl = (Compressor::Level)settings.integer(SettingKey::CompressionLevel);
+
+    auto progress = new QProgressDialog(tr("Training a dictionary on %n file(s)...", "",
+                                           files.size()), QString(), 0, 0, this);
+    progress->setWindowModality(Qt::WindowModal);
+    progress->setMinimumDuration(0);
+    progress->show();
+
+    auto train = [files, lvl](){
+        try {
+            return qMakePair(Dictionary::train(files, lvl), QString());
+        } catch (const QString &s) {
+            return qMakePair(Dictionary::Report(), s);
+        }
+    };
+
+    using Result = QPair<Dictionary::Report, QString>;
+    auto watcher = new QFutureWatcher<Result>(this);
+    connect(watcher, &QFutureWatcher<Result>::finished, [this, watcher, progress](){
+        watcher->deleteLater();
+        progress->deleteLater();
+
+        const Result res = watcher->result();
+        if (!res.second.isEmpty()) {
+            QMessageBox::warning(this, tr("Error"), res.second);
+            return;
+        }
+
+        const Dictionary::Report &r = res.first;
+        const qint64 saved = r.withoutDict - r.withDict;
+        const QString text =
+            tr("Dictionary size: %1.").arg(m_model->sizeText(r.dictSize)) + "\n\n"
+            + tr("On %n sample file(s) of %1:", "", r.files).arg(m_model->sizeText(r.plainSize))
+            + "\n"
+            + tr("without a dictionary: %1").arg(m_model->sizeText(r.withoutDict)) + "\n"
+            + tr("with the dictionary: %1").arg(m_model->sizeText(r.withDict)) + "\n"
+            + tr("saved: %1").arg(m_model->sizeText(saved)) + "\n\n"
+            + tr("Clients have to download the dictionary once, so it pays off "
+                 "when the saved bytes of all served files exceed its size.") + "\n\n"
+            + tr("Use the dictionary for Zstandard compression?");
+
+        auto btn = QMessageBox::question(this, tr("zstd Dictionary"), text,
+                                         QMessageBox::Yes, QMessageBox::No);
+        AppSettings().setValue(SettingKey::UseDictionary, btn == QMessageBox::Yes);
+    });
+    watcher->setFuture(QtConcurrent::run(train));
+}
+
+// The serving stack needs the same dictionary to decode files.
+void MainWindow::exportDictionary()
+{
+    const QString path = QFileDialog::getSaveFileName(this, tr("Export Dictionary"),
+                                                      lastPath() + "/svg.zstd-dict");
+    if (path.isEmpty()) {
+        return;
+    }
+
+    QFile::remove(path);
+    if (!QFile::copy(Dictionary::filePath(), path)) {
+        QMessageBox::warning(this, tr("Error"), tr("Failed to write a file: '%1'.").arg(path));
+    }
+}
+
+// Selected files are processed before the rest of the batch,
+// so the user doesn't have to wait for the whole run to see them.
+// Folders are skipped, otherwise a click on a root item would reorder the whole run.
+void MainWindow::onSelectionChanged()
+{
+    if (!m_scheduler->isRunning()) {
+        return;
+    }
+
+    QVector<TreeItem*> items;
+    for (const QModelIndex &index : ui->treeView->selectionModel()->selectedRows()) {
+        TreeItem *item = m_proxyModel->itemByIndex(index);
+        if (item && !item->isFolder()) {
+            items << item;
+        }
+    }
+
+    prioritize(items, false);
+}
+
+// Explicit requests go before files that were prioritized by the selection.
+void MainWindow::prioritize(const QVector<TreeItem*> &items, bool isExplicit)
+{
+    QVector<TreeItem*> files;
+    for (TreeItem *item : items) {
+        if (item->isFolder()) {
+            item->collectFiles(files);
+        } else {
+            files << item;
+        }
+    }
+
+    if (!files.isEmpty()) {
+        m_scheduler->prioritize(files, isExplicit);
+    }
 }
 
 void MainWindow::onDoubleClick(const QModelIndex &index)
@@ -599,18 +1511,24 @@ void MainWindow::onDoubleClick(const QModelIndex &index)
         return;
     }
 
-    if (index.column() == Column::Status) {
-        TreeItem *item = m_model->itemByIndex(index);
+    if (index.column() == Column::Name) {
+        // folders are expanded by a double click
+        TreeItem *item = m_proxyModel->itemByIndex(index);
+        if (item && !item->isFolder() && m_scheduler->isRunning()) {
+            prioritize({ item }, true);
+        }
+    } else if (index.column() == Column::Status) {
+        TreeItem *item = m_proxyModel->itemByIndex(index);
         if (item && !item->isFolder() && item->data().status != Status::Ok) {
             QMessageBox::information(this, tr("Status info"), item->data().statusText);
         }
     } else if (index.column() == Column::SizeBefore) {
-        TreeItem *item = m_model->itemByIndex(index);
-        QDesktopServices::openUrl(QUrl::fromLocalFile(item->data().path));
+        TreeItem *item = m_proxyModel->itemByIndex(index);
+        QDesktopServices::openUrl(QUrl::fromLocalFile(item->path()));
     } else if (index.column() == Column::SizeAfter) {
-        TreeItem *item = m_model->itemByIndex(index);
+        TreeItem *item = m_proxyModel->itemByIndex(index);
         if (!item->data().outPath.isEmpty()) {
-            QDesktopServices::openUrl(QUrl::fromLocalFile(item->data().outPath));
+            QDesktopServices::openUrl(QUrl::fromLocalFile(item->outputPath()));
         }
     }
 }
@@ -654,7 +1572,7 @@ void MainWindow::on_btnSelectFolder_clicked()
 
 void MainWindow::closeEvent(QCloseEvent *e)
 {
-    if (m_cleaningWatcher->isRunning()) {
+    if (m_scheduler->isRunning()) {
         auto btn = QMessageBox::question(this, tr("Quit?"),
                                          tr("Cleaning is in progress.\n\n"
                                             "Stop it and quit?"),
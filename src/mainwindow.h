@@ -23,15 +23,23 @@
 #pragma once
 
 #include <QMainWindow>
-#include <QFutureWatcher>
+#include <QSet>
 
 #include "cleaner.h"
+#include "folderwatcher.h"
+#include "journal.h"
+#include "resultqueue.h"
+#include "resultsproxymodel.h"
+#include "runconfig.h"
+#include "scheduler.h"
 #include "treemodel.h"
 
 #ifdef WITH_CHECK_UPDATES
 #include "updater.h"
 #endif
 
+class QTimer;
+
 namespace Ui {
 class MainWindow;
 }
@@ -47,6 +55,7 @@ public:
 private:
     void initToolBar();
     void initTree();
+    void setTransferColumnsVisible(bool flag);
     void initWatcher();
     void loadSettings();
     void saveSettings();    
@@ -54,8 +63,31 @@ private:
     void setPauseBtnVisible(bool flag);
     void setEnableGui(bool flag);
     void recalcTable();
-    void addFile(const QString &path);
-    void addFolder(const QString &path);
+    void addPaths(const QStringList &paths);
+    void restoreSession();
+    void checkSessionFiles();
+    void resumeJournal();
+    void processResults();
+    void applyResult(const Task::Output &res);
+    bool readRunConfig(RunConfig &run);
+    bool hasMainBatch() const;
+    bool readMainRunConfig(RunConfig &run);
+    void addMainBatch(const RunConfig &run);
+    bool prepareMainBatch();
+    void startTasks(int batchId, const QVector<Task::Config> &tasks);
+    void startBatch(TreeItem *item, int weight);
+    void addJournalBatch(int id, const QString &name, int weight, const RunConfig &run);
+    void updateProgress();
+    void onFoldersChanged(const QStringList &folders);
+    void onFilesReady(const QStringList &files);
+    void onTreeContextMenu(const QPoint &pos);
+    void onHeaderContextMenu(const QPoint &pos);
+    void onSelectionChanged();
+    void prioritize(const QVector<TreeItem*> &items, bool isExplicit);
+    void calibrate(TreeItem *item);
+    void trainDictionary(TreeItem *item);
+    void exportDictionary();
+    void onFilterChanged();
 
 #ifdef WITH_CHECK_UPDATES
     void checkUpdates(bool manual);
@@ -66,7 +98,6 @@ private slots:
     void onStart();
     void onPause();
     void onStop();
-    void onResultReadyAt(int idx);
     void onFinished();
     void onDoubleClick(const QModelIndex &index);
     void on_actionAddFiles_triggered();
@@ -74,6 +105,7 @@ private slots:
     void on_actionPreferences_triggered();
     void on_actionAbout_triggered();
     void on_btnSelectFolder_clicked();
+    void on_actionRefresh_triggered();
     void on_actionClearTree_triggered();
 
 #ifdef WITH_CHECK_UPDATES
@@ -88,7 +120,29 @@ protected:
 private:
     Ui::MainWindow * const ui;
     TreeModel * const m_model;
-    QFutureWatcher<Task::Output> * const m_cleaningWatcher;
+    ResultsProxyModel * const m_proxyModel;
+    ResultQueue m_results;
+    Scheduler * const m_scheduler;
+    FolderWatcher * const m_folderWatcher;
+    QTimer * const m_resultsTimer;
+    QTimer * const m_filterTimer;
+    Journal m_journal;
+    // Settings of the main batch.
+    RunConfig m_run;
+    int m_mainBatchId = 0;
+    int m_processedFiles = 0;
+    int m_totalFiles = 0;
+    bool m_isStopping = false;
+    // Watched folders with removed files, that will be refreshed after cleaning.
+    QSet<QString> m_postponedFolders;
+    // Restored files are checked for changes when no cleaning is running.
+    bool m_isSessionCheckPending = false;
+    bool m_isSessionCheckDeferred = false;
+    // Files cleaned while the check is pending. Their results are up to date.
+    QSet<TreeItem*> m_sessionCleanedItems;
+    // Watched files that became ready while calibrating. They are cleaned afterwards.
+    bool m_isCalibrating = false;
+    QStringList m_calibrationReadyFiles;
 
 #ifdef WITH_CHECK_UPDATES
     Updater * const m_updater;
@@ -24,7 +24,6 @@
 
 #include "src/enums.h"
 #include "src/settings.h"
-#include "src/process.h"
 #include "src/compressor.h"
 
 #include "mainpage.h"
@@ -33,6 +32,10 @@
 namespace CompressorTitle {
     static const QString SevenZip = "7-Zip";
     static const QString Zopfli   = "Zopfli";
+    static const QString Deflate  = "Built-in gzip";
+    static const QString BestOf   = "Best of All";
+    static const QString Brotli   = "Brotli";
+    static const QString Zstd     = "Zstandard";
 }
 
 MainPage::MainPage(QWidget *parent)
@@ -44,8 +47,21 @@ MainPage::MainPage(QWidget *parent)
     ui->spinBoxJobs->setMaximum(QThread::idealThreadCount());
 
     ui->widgetZopfliWarning->hide();
+    ui->widgetBestOf->hide();
     initZip();
 
+    connect(ui->chBoxSidecars, &QCheckBox::toggled, [this](bool flag){
+        ui->widgetSidecars->setEnabled(flag);
+        ui->chBoxSvgzOnly->setEnabled(!flag);
+    });
+
+    ui->widgetBlockZip->setVisible(Compressor::isBlockModeAvailable());
+    connect(ui->chBoxBlockZip, &QCheckBox::toggled,
+            ui->spinBoxBlockThreshold, &QSpinBox::setEnabled);
+
+    connect(ui->chBoxSkipUnchanged, &QCheckBox::toggled,
+            ui->spinBoxUnchangedThreshold, &QSpinBox::setEnabled);
+
 #ifndef WITH_CHECK_UPDATES
     ui->chBoxCheckUpdates->hide();
     ui->btnCheckUpdates->hide();
@@ -61,11 +77,32 @@ void MainPage::initZip()
 {
     ui->cmbBoxZip->addItem(CompressorTitle::SevenZip, CompressorName::SevenZip);
 
-    try {
-        Process::run(CompressorName::Zopfli, { "-h" }, 1000);
+    if (Compressor(Compressor::Zopfli).isAvailable()) {
         ui->cmbBoxZip->addItem(CompressorTitle::Zopfli, CompressorName::Zopfli);
-    } catch (...) {
-        // ignore
+    }
+
+    if (Compressor(Compressor::Deflate).isAvailable()) {
+        ui->cmbBoxZip->addItem(CompressorTitle::Deflate, CompressorName::Deflate);
+    }
+
+    // only when there is something to choose from
+    if (ui->cmbBoxZip->count() > 1) {
+        ui->cmbBoxZip->addItem(CompressorTitle::BestOf, CompressorName::BestOf);
+    }
+
+    ui->chBoxBestOfSevenZip->setText(CompressorTitle::SevenZip);
+    ui->chBoxBestOfZopfli->setText(CompressorTitle::Zopfli);
+    ui->chBoxBestOfDeflate->setText(CompressorTitle::Deflate);
+    ui->chBoxBestOfZopfli->setEnabled(Compressor(Compressor::Zopfli).isAvailable());
+    ui->chBoxBestOfDeflate->setEnabled(Compressor(Compressor::Deflate).isAvailable());
+
+    // not gzip, so they produce .svg.br and .svg.zst files instead of .svgz
+    if (Compressor(Compressor::Brotli).isAvailable()) {
+        ui->cmbBoxZip->addItem(CompressorTitle::Brotli, CompressorName::Brotli);
+    }
+
+    if (Compressor(Compressor::Zstd).isAvailable()) {
+        ui->cmbBoxZip->addItem(CompressorTitle::Zstd, CompressorName::Zstd);
     }
 }
 
@@ -84,6 +121,28 @@ void MainPage::loadConfig()
     ui->cmbBoxZipLevel->setCurrentIndex(settings.integer(SettingKey::CompressionLevel));
     ui->chBoxSvgzOnly->setChecked(settings.flag(SettingKey::CompressOnlySvgz));
 
+    const QStringList bestOf = settings.string(SettingKey::BestOfCompressors).split(',');
+    ui->chBoxBestOfSevenZip->setChecked(bestOf.contains(CompressorName::SevenZip));
+    ui->chBoxBestOfZopfli->setChecked(bestOf.contains(CompressorName::Zopfli));
+    ui->chBoxBestOfDeflate->setChecked(bestOf.contains(CompressorName::Deflate));
+
+    ui->chBoxBlockZip->setChecked(settings.flag(SettingKey::BlockCompression));
+    ui->spinBoxBlockThreshold->setEnabled(ui->chBoxBlockZip->isChecked());
+    ui->spinBoxBlockThreshold->setValue(settings.integer(SettingKey::BlockThreshold));
+
+    ui->chBoxSidecars->setChecked(settings.flag(SettingKey::Sidecars));
+    ui->widgetSidecars->setEnabled(ui->chBoxSidecars->isChecked());
+    ui->chBoxSvgzOnly->setEnabled(!ui->chBoxSidecars->isChecked());
+    const QStringList formats = settings.string(SettingKey::SidecarFormats).split(',');
+    ui->chBoxSidecarGz->setChecked(formats.contains("gz"));
+    ui->chBoxSidecarBr->setChecked(formats.contains("br"));
+    ui->chBoxSidecarZst->setChecked(formats.contains("zst"));
+    ui->spinBoxSidecarThreshold->setValue(settings.integer(SettingKey::SidecarThreshold));
+
+    ui->chBoxSkipUnchanged->setChecked(settings.flag(SettingKey::SkipUnchanged));
+    ui->spinBoxUnchangedThreshold->setEnabled(ui->chBoxSkipUnchanged->isChecked());
+    ui->spinBoxUnchangedThreshold->setValue(settings.integer(SettingKey::UnchangedThreshold));
+
     ui->chBoxCheckUpdates->setChecked(settings.flag(SettingKey::CheckUpdates));
 
     CleanerOptions opt;
@@ -109,6 +168,39 @@ void MainPage::saveConfig()
     settings.setValue(SettingKey::Compressor, ui->cmbBoxZip->currentData());
     settings.setValue(SettingKey::CompressionLevel, ui->cmbBoxZipLevel->currentIndex());
     settings.setValue(SettingKey::CompressOnlySvgz, ui->chBoxSvgzOnly->isChecked());
+
+    QStringList bestOf;
+    if (ui->chBoxBestOfSevenZip->isChecked()) {
+        bestOf << CompressorName::SevenZip;
+    }
+    if (ui->chBoxBestOfZopfli->isChecked()) {
+        bestOf << CompressorName::Zopfli;
+    }
+    if (ui->chBoxBestOfDeflate->isChecked()) {
+        bestOf << CompressorName::Deflate;
+    }
+    settings.setValue(SettingKey::BestOfCompressors, bestOf.join(','));
+
+    settings.setValue(SettingKey::BlockCompression, ui->chBoxBlockZip->isChecked());
+    settings.setValue(SettingKey::BlockThreshold, ui->spinBoxBlockThreshold->value());
+
+    QStringList formats;
+    if (ui->chBoxSidecarGz->isChecked()) {
+        formats << "gz";
+    }
+    if (ui->chBoxSidecarBr->isChecked()) {
+        formats << "br";
+    }
+    if (ui->chBoxSidecarZst->isChecked()) {
+        formats << "zst";
+    }
+    settings.setValue(SettingKey::Sidecars, ui->chBoxSidecars->isChecked());
+    settings.setValue(SettingKey::SidecarFormats, formats.join(','));
+    settings.setValue(SettingKey::SidecarThreshold, ui->spinBoxSidecarThreshold->value());
+
+    settings.setValue(SettingKey::SkipUnchanged, ui->chBoxSkipUnchanged->isChecked());
+    settings.setValue(SettingKey::UnchangedThreshold, ui->spinBoxUnchangedThreshold->value());
+
     settings.setValue(SettingKey::CheckUpdates, ui->chBoxCheckUpdates->isChecked());
 
     int method = AppSettings::SelectFolder;
@@ -133,6 +225,18 @@ void MainPage::restoreDefaults()
     ui->rBtnSave1->setChecked(true);
     ui->cmbBoxZipLevel->setCurrentIndex(settings.defaultInt(SettingKey::CompressionLevel));
     ui->chBoxSvgzOnly->setChecked(settings.defaultFlag(SettingKey::CompressOnlySvgz));
+    ui->chBoxBestOfSevenZip->setChecked(true);
+    ui->chBoxBestOfZopfli->setChecked(true);
+    ui->chBoxBestOfDeflate->setChecked(true);
+    ui->chBoxBlockZip->setChecked(settings.defaultFlag(SettingKey::BlockCompression));
+    ui->spinBoxBlockThreshold->setValue(settings.defaultInt(SettingKey::BlockThreshold));
+    ui->chBoxSidecars->setChecked(settings.defaultFlag(SettingKey::Sidecars));
+    ui->chBoxSidecarGz->setChecked(true);
+    ui->chBoxSidecarBr->setChecked(false);
+    ui->chBoxSidecarZst->setChecked(false);
+    ui->spinBoxSidecarThreshold->setValue(settings.defaultInt(SettingKey::SidecarThreshold));
+    ui->chBoxSkipUnchanged->setChecked(settings.defaultFlag(SettingKey::SkipUnchanged));
+    ui->spinBoxUnchangedThreshold->setValue(settings.defaultInt(SettingKey::UnchangedThreshold));
 
     QString compressor = settings.defaultValue(SettingKey::Compressor).toString();
     int compressorIdx = ui->cmbBoxZip->findData(compressor);
@@ -146,7 +250,12 @@ void MainPage::restoreDefaults()
 
 void MainPage::on_cmbBoxZip_currentTextChanged(const QString &text)
 {
-    ui->widgetZopfliWarning->setVisible(text == CompressorTitle::Zopfli);
+    // best-of runs zopfli too
+    const bool isBestOf = text == CompressorTitle::BestOf;
+    const bool hasZopfli = text == CompressorTitle::Zopfli
+        || (isBestOf && ui->chBoxBestOfZopfli->isEnabled());
+    ui->widgetZopfliWarning->setVisible(hasZopfli);
+    ui->widgetBestOf->setVisible(isBestOf);
     prepareZipLvlToolTip();
 }
 
@@ -0,0 +1,57 @@
+/****************************************************************************
+**
+** SVG Cleaner could help you to clean up your SVG files
+** from unnecessary data.
+** Copyright (C) 2012-2018 Evgeniy Reizner
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License along
+** with this program; if not, write to the Free Software Foundation, Inc.,
+** 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+**
+****************************************************************************/
+
+#include <algorithm>
+
+#include "resultqueue.h"
+
+ResultQueue::~ResultQueue()
+{
+    takeAll();
+}
+
+void ResultQueue::push(const Task::Output &output)
+{
+    Node *node = new Node { output, nullptr };
+    Node *head = m_head.loadAcquire();
+    do {
+        node->next = head;
+    } while (!m_head.testAndSetOrdered(head, node, head));
+}
+
+QVector<Task::Output> ResultQueue::takeAll()
+{
+    Node *node = m_head.fetchAndStoreAcquire(nullptr);
+
+    QVector<Task::Output> list;
+    while (node) {
+        list << node->output;
+        Node *next = node->next;
+        delete node;
+        node = next;
+    }
+
+    // we are using a stack internally, so results are in the reverse order
+    std::reverse(list.begin(), list.end());
+
+    return list;
+}
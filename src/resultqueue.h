@@ -0,0 +1,51 @@
+/****************************************************************************
+**
+** SVG Cleaner could help you to clean up your SVG files
+** from unnecessary data.
+** Copyright (C) 2012-2018 Evgeniy Reizner
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License along
+** with this program; if not, write to the Free Software Foundation, Inc.,
+** 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+**
+****************************************************************************/
+
+#pragma once
+
+#include <QAtomicPointer>
+#include <QVector>
+
+#include "cleaner.h"
+
+// A lock-free multi-producer/single-consumer queue for cleaning results.
+// Worker threads push results one by one and the GUI thread takes all of them at once.
+class ResultQueue
+{
+public:
+    ResultQueue() = default;
+    ~ResultQueue();
+
+    void push(const Task::Output &output);
+    QVector<Task::Output> takeAll();
+
+private:
+    Q_DISABLE_COPY(ResultQueue)
+
+    struct Node
+    {
+        Task::Output output;
+        Node *next;
+    };
+
+    QAtomicPointer<Node> m_head;
+};
@@ -0,0 +1,216 @@
+/****************************************************************************
+**
+** SVG Cleaner could help you to clean up your SVG files
+** from unnecessary data.
+** Copyright (C) 2012-2018 Evgeniy Reizner
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License along
+** with this program; if not, write to the Free Software Foundation, Inc.,
+** 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+**
+****************************************************************************/
+
+#include <algorithm>
+
+#include "resultsproxymodel.h"
+
+static int statusBit(Status status)
+{
+    return 1 << int(status);
+}
+
+ResultsProxyModel::ResultsProxyModel(QObject *parent)
+    : QSortFilterProxyModel(parent)
+{
+}
+
+void ResultsProxyModel::setTreeModel(TreeModel *model)
+{
+    m_model = model;
+    setSourceModel(model);
+}
+
+TreeItem *ResultsProxyModel::itemByIndex(const QModelIndex &index) const
+{
+    return m_model->itemByIndex(mapToSource(index));
+}
+
+void ResultsProxyModel::setStatusFilter(StatusFilter filter)
+{
+    switch (filter) {
+        case AllStatuses :       m_statusMask = 0; break;
+        case NotProcessed :      m_statusMask = statusBit(Status::None); break;
+        case OkOnly :            m_statusMask = statusBit(Status::Ok); break;
+        case WarningsOnly :      m_statusMask = statusBit(Status::Warning); break;
+        case ErrorsOnly :        m_statusMask = statusBit(Status::Error); break;
+        case WarningsAndErrors : m_statusMask =   statusBit(Status::Warning)
+                                                | statusBit(Status::Error); break;
+        case UnchangedOnly :     m_statusMask = statusBit(Status::Unchanged); break;
+    }
+
+    invalidateFilter();
+}
+
+void ResultsProxyModel::setPathFilter(const QString &text)
+{
+    m_pathFilter = text;
+    updatePathMatches();
+    invalidateFilter();
+}
+
+bool ResultsProxyModel::hasFilter() const
+{
+    return m_statusMask != 0 || !m_pathFilter.isEmpty();
+}
+
+void ResultsProxyModel::updateIndex()
+{
+    // all rows are accepted anyway, and the path index is already cleared
+    if (!hasFilter()) {
+        return;
+    }
+
+    clearPathIndex();
+    updatePathMatches();
+    invalidateFilter();
+}
+
+void ResultsProxyModel::clearPathIndex()
+{
+    m_isPathIndexValid = false;
+    m_pathText = QString();
+    m_pathOffsets = QVector<int>();
+    m_pathItems = QVector<TreeItem*>();
+}
+
+void ResultsProxyModel::buildPathIndex()
+{
+    indexFolder(m_model->rootItem(), QString());
+    m_isPathIndexValid = true;
+}
+
+void ResultsProxyModel::indexFolder(TreeItem *parent, const QString &parentPath)
+{
+    for (TreeItem *item : parent->childrenList()) {
+        const QString path = parentPath.isEmpty() ? item->name() : parentPath + '/' + item->name();
+        if (item->isFolder()) {
+            indexFolder(item, path);
+        } else {
+            m_pathOffsets << m_pathText.size();
+            m_pathItems << item;
+            m_pathText += path.toLower();
+            m_pathText += '\n';
+        }
+    }
+}
+
+void ResultsProxyModel::updatePathMatches()
+{
+    m_pathMatches.clear();
+    if (m_pathFilter.isEmpty()) {
+        // the index is large, so it's kept only while it's used
+        clearPathIndex();
+        return;
+    }
+
+    if (!m_isPathIndexValid) {
+        buildPathIndex();
+    }
+
+    const QString needle = m_pathFilter.toLower();
+    int pos = m_pathText.indexOf(needle);
+    while (pos != -1) {
+        // find a path that contains the match
+        const auto it = std::upper_bound(m_pathOffsets.constBegin(), m_pathOffsets.constEnd(), pos);
+        const int idx = int(it - m_pathOffsets.constBegin()) - 1;
+
+        // a file and all its parents are shown
+        for (TreeItem *item = m_pathItems.at(idx); item && item != m_model->rootItem();
+             item = item->parent()) {
+            if (m_pathMatches.contains(item)) {
+                break;
+            }
+            m_pathMatches.insert(item);
+        }
+
+        // skip the rest of the path
+        const int next = idx + 1 < m_pathOffsets.size() ? m_pathOffsets.at(idx + 1)
+                                                        : m_pathText.size();
+        pos = m_pathText.indexOf(needle, next);
+    }
+}
+
+bool ResultsProxyModel::isStatusAccepted(TreeItem *item) const
+{
+    if (m_statusMask == 0) {
+        return true;
+    }
+
+    // Folder stats count only checked files, so unchecked ones are skipped here too.
+    // Otherwise they would be hidden anyway when no checked file of the folder is accepted.
+    if (!item->isFolder()) {
+        return item->checkState() == Qt::Checked && (m_statusMask & statusBit(item->data().status));
+    }
+
+    // a folder is shown when it has at least one file with a required status
+    const FolderStats &stats = item->folderStats();
+    for (auto status : { Status::None, Status::Ok, Status::Warning, Status::Error,
+                         Status::Unchanged }) {
+        if ((m_statusMask & statusBit(status)) && stats.count(status) > 0) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool ResultsProxyModel::filterAcceptsRow(int sourceRow, const QModelIndex &sourceParent) const
+{
+    if (!hasFilter()) {
+        return true;
+    }
+
+    TreeItem *parent = sourceParent.isValid() ? m_model->itemByIndex(sourceParent)
+                                              : m_model->rootItem();
+    TreeItem *item = parent->child(sourceRow);
+
+    if (!m_pathFilter.isEmpty() && !m_pathMatches.contains(item)) {
+        return false;
+    }
+
+    return isStatusAccepted(item);
+}
+
+bool ResultsProxyModel::lessThan(const QModelIndex &left, const QModelIndex &right) const
+{
+    // compare raw values and not display strings
+    const TreeItem *l = m_model->itemByIndex(left);
+    const TreeItem *r = m_model->itemByIndex(right);
+    const TreeItemData &ld = l->data();
+    const TreeItemData &rd = r->data();
+
+    switch (left.column()) {
+        case Column::Name :
+            return QString::compare(l->title(), r->title(), Qt::CaseInsensitive) < 0;
+        case Column::SizeBefore : return ld.sizeBefore < rd.sizeBefore;
+        case Column::SizeAfter :  return ld.sizeAfter < rd.sizeAfter;
+        case Column::Ratio :      return ld.ratio < rd.ratio;
+        case Column::TransferBefore : return ld.transferBefore.gzip < rd.transferBefore.gzip;
+        case Column::TransferAfter :  return ld.transferAfter.gzip < rd.transferAfter.gzip;
+        case Column::TransferRatio :  return ld.transferRatio < rd.transferRatio;
+        case Column::Status :     return int(ld.status) < int(rd.status);
+        default: break;
+    }
+
+    return false;
+}
@@ -0,0 +1,84 @@
+/****************************************************************************
+**
+** SVG Cleaner could help you to clean up your SVG files
+** from unnecessary data.
+** Copyright (C) 2012-2018 Evgeniy Reizner
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License along
+** with this program; if not, write to the Free Software Foundation, Inc.,
+** 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+**
+****************************************************************************/
+
+#pragma once
+
+#include <QSet>
+#include <QSortFilterProxyModel>
+
+#include "treemodel.h"
+
+class ResultsProxyModel : public QSortFilterProxyModel
+{
+public:
+    // Matches the rows of the status filter combo box.
+    enum StatusFilter
+    {
+        AllStatuses,
+        NotProcessed,
+        OkOnly,
+        WarningsOnly,
+        ErrorsOnly,
+        WarningsAndErrors,
+        UnchangedOnly,
+    };
+
+    explicit ResultsProxyModel(QObject *parent = nullptr);
+
+    void setTreeModel(TreeModel *model);
+    TreeItem *itemByIndex(const QModelIndex &index) const;
+
+    void setStatusFilter(StatusFilter filter);
+    void setPathFilter(const QString &text);
+    bool hasFilter() const;
+
+    // Should be called after the tree was changed.
+    void updateIndex();
+
+protected:
+    bool filterAcceptsRow(int sourceRow, const QModelIndex &sourceParent) const;
+    bool lessThan(const QModelIndex &left, const QModelIndex &right) const;
+
+private:
+    bool isStatusAccepted(TreeItem *item) const;
+    void buildPathIndex();
+    void clearPathIndex();
+    void indexFolder(TreeItem *parent, const QString &parentPath);
+    void updatePathMatches();
+
+private:
+    TreeModel *m_model = nullptr;
+    int m_statusMask = 0;
+    QString m_pathFilter;
+
+    // Lowercased paths of all files, separated by '\n', and their items.
+    // Built once per tree change while a path filter is set,
+    // so each filter change is a single search through a flat buffer.
+    QString m_pathText;
+    QVector<int> m_pathOffsets;
+    QVector<TreeItem*> m_pathItems;
+    bool m_isPathIndexValid = false;
+
+    // Files that match the path filter and all their parents.
+    // So we don't have to build and check paths for each row and each folder.
+    QSet<TreeItem*> m_pathMatches;
+};
@@ -0,0 +1,56 @@
+/****************************************************************************
+**
+** SVG Cleaner could help you to clean up your SVG files
+** from unnecessary data.
+** Copyright (C) 2012-2018 Evgeniy Reizner
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License along
+** with this program; if not, write to the Free Software Foundation, Inc.,
+** 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+**
+****************************************************************************/
+
+#pragma once
+
+#include <QStringList>
+
+#include "compressor.h"
+#include "settings.h"
+
+// A snapshot of the settings used by a cleaning batch.
+struct RunConfig
+{
+    AppSettings::SavingMethod method = AppSettings::SameFolder;
+    QString outFolder;
+    QString rootFolder;
+    QString filePrefix;
+    QString fileSuffix;
+    QStringList args;
+    Compressor::Type compressorType = Compressor::None;
+    Compressor::Level compressionLevel = Compressor::Ultra;
+    bool compressOnlySvgz = false;
+    // There are spare cores for the best-of compression.
+    bool isParallelZip = false;
+    // Compressors raced by the best-of compression.
+    QVector<Compressor::Type> bestOfCompressors;
+    // In bytes. Zero when large files are compressed as a whole.
+    qint64 blockThreshold = 0;
+    QVector<Compressor::Type> sidecars;
+    int sidecarThreshold = 0;
+    // A path to a zstd dictionary, if used.
+    QString zstdDictionary;
+    // The transfer columns are shown.
+    bool isTransferEstimated = false;
+    // Zero when files are always rewritten.
+    int unchangedThreshold = 0;
+};
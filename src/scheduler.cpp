@@ -0,0 +1,453 @@
+/****************************************************************************
+**
+** SVG Cleaner could help you to clean up your SVG files
+** from unnecessary data.
+** Copyright (C) 2012-2018 Evgeniy Reizner
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License along
+** with this program; if not, write to the Free Software Foundation, Inc.,
+** 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+**
+****************************************************************************/
+
+#include "resultqueue.h"
+#include "scheduler.h"
+
+static const quint64 Stride = 1 << 16;
+
+class Scheduler::Worker : public QRunnable
+{
+public:
+    explicit Worker(Scheduler *scheduler) : m_scheduler(scheduler) {}
+    void run() { m_scheduler->runWorker(); }
+
+private:
+    Scheduler * const m_scheduler;
+};
+
+Scheduler::Scheduler(ResultQueue *results, QObject *parent)
+    : QObject(parent)
+    , m_results(results)
+{
+    // Keep threads alive between batches and between files added to a running batch.
+    m_pool.setExpiryTimeout(-1);
+}
+
+Scheduler::~Scheduler()
+{
+    blockSignals(true);
+    {
+        QMutexLocker locker(&m_mutex);
+        m_batches.clear();
+        m_tasks.clear();
+        m_priorityQueue.clear();
+        m_deferred.clear();
+        m_queued = 0;
+    }
+    m_pool.waitForDone();
+}
+
+void Scheduler::setMaxThreadCount(int count)
+{
+    m_pool.setMaxThreadCount(count);
+}
+
+int Scheduler::addBatch(const QString &name, int weight)
+{
+    QMutexLocker locker(&m_mutex);
+
+    if (m_workers == 0 && m_queued == 0) {
+        m_batches.clear();
+    }
+
+    Batch batch;
+    batch.info.id = m_nextBatchId++;
+    batch.info.name = name;
+    batch.info.weight = qMax(1, weight);
+    m_batches << batch;
+
+    return batch.info.id;
+}
+
+void Scheduler::enqueue(int batchId, const QVector<Task::Config> &tasks)
+{
+    QMutexLocker locker(&m_mutex);
+
+    Batch *batch = findBatch(batchId);
+    Q_ASSERT(batch);
+    if (!batch || tasks.isEmpty()) {
+        return;
+    }
+
+    // an idle batch must not take the whole pool until it catches up with others
+    if (batch->queued == 0) {
+        batch->pass = qMax(batch->pass, minPass());
+    }
+
+    for (const Task::Config &task : tasks) {
+        addTask(batch, task);
+    }
+
+    startWorkers();
+}
+
+bool Scheduler::hasBatch(int id) const
+{
+    QMutexLocker locker(&m_mutex);
+    for (const Batch &batch : m_batches) {
+        if (batch.info.id == id) {
+            return true;
+        }
+    }
+    return false;
+}
+
+QVector<Scheduler::BatchInfo> Scheduler::batches() const
+{
+    QMutexLocker locker(&m_mutex);
+
+    QVector<BatchInfo> list;
+    list.reserve(m_batches.size());
+    for (const Batch &batch : m_batches) {
+        list << batch.info;
+    }
+    return list;
+}
+
+int Scheduler::prioritize(const QVector<TreeItem*> &items, bool isExplicit)
+{
+    QMutexLocker locker(&m_mutex);
+
+    int moved = 0;
+    // prepended in reverse, so the order is kept
+    for (int i = 0; i < items.size(); ++i) {
+        TreeItem *item = isExplicit ? items.at(items.size() - 1 - i) : items.at(i);
+        auto it = m_tasks.find(item);
+        if (it == m_tasks.end()) {
+            continue;
+        }
+
+        if (!it->isPrioritized) {
+            detach(*it);
+            it->isPrioritized = true;
+            m_prioritized++;
+        } else if (!isExplicit) {
+            continue;
+        }
+
+        // an older position in the queue is skipped, since the task is taken by then
+        if (isExplicit) {
+            m_priorityQueue.prepend(item);
+        } else {
+            m_priorityQueue.enqueue(item);
+        }
+        moved++;
+    }
+
+    return moved;
+}
+
+int Scheduler::remove(const QSet<TreeItem*> &items)
+{
+    QMutexLocker locker(&m_mutex);
+
+    int removed = 0;
+    for (TreeItem *item : items) {
+        auto it = m_tasks.find(item);
+        if (it != m_tasks.end()) {
+            detach(*it);
+            if (Batch *batch = findBatch(it->batchId)) {
+                batch->info.total--;
+            }
+            m_tasks.erase(it);
+            removed++;
+        }
+
+        auto deferredIt = m_deferred.find(item);
+        if (deferredIt != m_deferred.end()) {
+            if (Batch *batch = findBatch(deferredIt->batchId)) {
+                batch->info.total--;
+            }
+            m_deferred.erase(deferredIt);
+            removed++;
+        }
+    }
+
+    m_queued -= removed;
+
+    return removed;
+}
+
+void Scheduler::pause()
+{
+    QMutexLocker locker(&m_mutex);
+    m_paused = true;
+}
+
+void Scheduler::resume()
+{
+    QMutexLocker locker(&m_mutex);
+    m_paused = false;
+    startWorkers();
+}
+
+void Scheduler::cancel()
+{
+    QMutexLocker locker(&m_mutex);
+    const bool hasQueued = m_queued > 0;
+    for (const Entry &entry : m_tasks) {
+        if (Batch *batch = findBatch(entry.batchId)) {
+            batch->info.total--;
+        }
+    }
+    m_tasks.clear();
+    for (Batch &batch : m_batches) {
+        batch.queue.clear();
+        batch.queued = 0;
+    }
+    m_priorityQueue.clear();
+    m_prioritized = 0;
+    for (const Entry &entry : m_deferred) {
+        if (Batch *batch = findBatch(entry.batchId)) {
+            batch->info.total--;
+        }
+    }
+    m_deferred.clear();
+    m_queued = 0;
+    m_paused = false;
+
+    // paused workers are already gone, so nobody will report it
+    if (hasQueued && m_workers == 0) {
+        locker.unlock();
+        emit finished();
+    }
+}
+
+bool Scheduler::isRunning() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_workers > 0 || m_queued > 0;
+}
+
+bool Scheduler::isPaused() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_paused;
+}
+
+// Methods below must be called with a locked mutex.
+
+Scheduler::Batch *Scheduler::findBatch(int id)
+{
+    for (Batch &batch : m_batches) {
+        if (batch.info.id == id) {
+            return &batch;
+        }
+    }
+    return nullptr;
+}
+
+quint64 Scheduler::minPass() const
+{
+    quint64 pass = 0;
+    bool isFound = false;
+    for (const Batch &batch : m_batches) {
+        if (batch.queued > 0 && (!isFound || batch.pass < pass)) {
+            pass = batch.pass;
+            isFound = true;
+        }
+    }
+    return pass;
+}
+
+// A newer task replaces a queued one.
+void Scheduler::addTask(Batch *batch, const Task::Config &task)
+{
+    auto it = m_tasks.find(task.treeItem);
+    if (it != m_tasks.end()) {
+        detach(*it);
+        if (Batch *oldBatch = findBatch(it->batchId)) {
+            oldBatch->info.total--;
+        }
+        m_tasks.erase(it);
+        m_queued--;
+    }
+
+    Entry entry;
+    entry.config = task;
+    entry.batchId = batch->info.id;
+    m_tasks.insert(task.treeItem, entry);
+
+    batch->queue.enqueue(task.treeItem);
+    batch->queued++;
+    batch->info.total++;
+    m_queued++;
+}
+
+// The task leaves its queue. Skipped positions are dropped once the queue has no tasks.
+void Scheduler::detach(const Entry &entry)
+{
+    if (entry.isPrioritized) {
+        if (--m_prioritized == 0) {
+            m_priorityQueue.clear();
+        }
+    } else if (Batch *batch = findBatch(entry.batchId)) {
+        if (--batch->queued == 0) {
+            batch->queue.clear();
+        }
+    }
+}
+
+bool Scheduler::takeQueued(Entry &entry)
+{
+    // tasks requested by the user go first
+    while (m_prioritized > 0) {
+        TreeItem *item = m_priorityQueue.dequeue();
+        auto it = m_tasks.find(item);
+        if (it == m_tasks.end() || !it->isPrioritized) {
+            continue;
+        }
+
+        entry = *it;
+        detach(entry);
+        m_tasks.erase(it);
+        m_queued--;
+        return true;
+    }
+
+    Batch *next = nullptr;
+    for (Batch &batch : m_batches) {
+        if (batch.queued > 0 && (!next || batch.pass < next->pass)) {
+            next = &batch;
+        }
+    }
+
+    if (!next) {
+        return false;
+    }
+
+    forever {
+        TreeItem *item = next->queue.dequeue();
+        auto it = m_tasks.find(item);
+        if (it != m_tasks.end() && !it->isPrioritized && it->batchId == next->info.id) {
+            entry = *it;
+            m_tasks.erase(it);
+            break;
+        }
+    }
+
+    next->pass += Stride / next->info.weight;
+    detach(entry);
+    m_queued--;
+
+    return true;
+}
+
+// Skips tasks for files that are being processed by other workers.
+bool Scheduler::takeNext(Entry &entry)
+{
+    while (takeQueued(entry)) {
+        if (!m_running.contains(entry.config.treeItem)) {
+            m_running.insert(entry.config.treeItem);
+            return true;
+        }
+
+        defer(entry);
+    }
+
+    return false;
+}
+
+void Scheduler::defer(const Entry &entry)
+{
+    auto it = m_deferred.find(entry.config.treeItem);
+    if (it != m_deferred.end()) {
+        // an older task is superseded
+        if (Batch *batch = findBatch(it->batchId)) {
+            batch->info.total--;
+        }
+        *it = entry;
+    } else {
+        m_deferred.insert(entry.config.treeItem, entry);
+        m_queued++;
+    }
+}
+
+void Scheduler::startWorkers()
+{
+    if (m_paused) {
+        return;
+    }
+
+    const int count = qMin(m_queued, m_pool.maxThreadCount()) - m_workers;
+    for (int i = 0; i < count; ++i) {
+        m_workers++;
+        m_pool.start(new Worker(this));
+    }
+}
+
+// Each worker takes tasks until the queues are empty, so a thread is not
+// rescheduled for each file.
+void Scheduler::runWorker()
+{
+    Entry entry;
+    bool hasProcessed = false;
+
+    forever {
+        {
+            QMutexLocker locker(&m_mutex);
+
+            if (hasProcessed) {
+                if (Batch *batch = findBatch(entry.batchId)) {
+                    batch->info.processed++;
+                }
+
+                // a waiting task for the same file goes next
+                TreeItem *item = entry.config.treeItem;
+                m_running.remove(item);
+                auto it = m_deferred.find(item);
+                if (it != m_deferred.end()) {
+                    if (m_tasks.contains(item)) {
+                        // superseded by a task that was queued after it
+                        if (Batch *batch = findBatch(it->batchId)) {
+                            batch->info.total--;
+                        }
+                        m_queued--;
+                    } else {
+                        Entry next = *it;
+                        next.isPrioritized = true;
+                        m_tasks.insert(item, next);
+                        m_priorityQueue.prepend(item);
+                        m_prioritized++;
+                    }
+                    m_deferred.erase(it);
+                }
+            }
+
+            if (m_paused || !takeNext(entry)) {
+                m_workers--;
+                const bool isDone = m_workers == 0 && m_queued == 0;
+                locker.unlock();
+
+                if (isDone) {
+                    emit finished();
+                }
+                return;
+            }
+        }
+
+        entry.config.blockPool = &m_pool;
+        m_results->push(Task::cleanFile(entry.config));
+        hasProcessed = true;
+    }
+}
@@ -0,0 +1,142 @@
+/****************************************************************************
+**
+** SVG Cleaner could help you to clean up your SVG files
+** from unnecessary data.
+** Copyright (C) 2012-2018 Evgeniy Reizner
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License along
+** with this program; if not, write to the Free Software Foundation, Inc.,
+** 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+**
+****************************************************************************/
+
+#pragma once
+
+#include <QHash>
+#include <QMutex>
+#include <QObject>
+#include <QQueue>
+#include <QSet>
+#include <QThreadPool>
+
+#include "cleaner.h"
+
+class ResultQueue;
+
+// Runs cleaning tasks on a thread pool and pushes results to a ResultQueue.
+// Unlike QtConcurrent::map(), new tasks can be added while it's running.
+//
+// Tasks are grouped into batches, which share the pool in proportion to their weights.
+//
+// A file has at most one queued task, a newer one replaces it. A file is never processed
+// by two workers at once. A task for a file that is being processed waits until
+// the running one is done.
+class Scheduler : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct BatchInfo
+    {
+        int id = 0;
+        QString name;
+        int weight = 1;
+        int total = 0;
+        int processed = 0;
+    };
+
+    explicit Scheduler(ResultQueue *results, QObject *parent = nullptr);
+    ~Scheduler();
+
+    void setMaxThreadCount(int count);
+
+    // Finished batches are removed when a batch is added to an idle scheduler.
+    int addBatch(const QString &name, int weight = 1);
+    void enqueue(int batchId, const QVector<Task::Config> &tasks);
+    bool hasBatch(int id) const;
+    QVector<BatchInfo> batches() const;
+
+    // Moves queued tasks of the items ahead of all batches. Explicit requests go before
+    // all previously prioritized tasks, others - after them.
+    // Returns the number of moved tasks.
+    int prioritize(const QVector<TreeItem*> &items, bool isExplicit);
+    // Removes queued and waiting tasks of the items. Returns the number of removed tasks.
+    int remove(const QSet<TreeItem*> &items);
+
+    // Running tasks are always finished, only queued ones are affected.
+    void pause();
+    void resume();
+    void cancel();
+
+    bool isRunning() const;
+    bool isPaused() const;
+
+signals:
+    // Emitted when all queues are empty and all workers are done.
+    void finished();
+
+private:
+    class Worker;
+
+    struct Entry
+    {
+        Task::Config config;
+        int batchId = 0;
+        // Queued in m_priorityQueue instead of the batch queue.
+        bool isPrioritized = false;
+    };
+
+    struct Batch
+    {
+        BatchInfo info;
+        // Files in the order of adding. Tasks are stored in m_tasks, so a file is skipped
+        // when its task was removed, replaced or prioritized.
+        QQueue<TreeItem*> queue;
+        // Tasks that are still taken from the queue.
+        int queued = 0;
+        // Grows on each taken task in inverse proportion to the weight.
+        // A batch with the smallest value goes next.
+        quint64 pass = 0;
+    };
+
+    Batch *findBatch(int id);
+    quint64 minPass() const;
+    void addTask(Batch *batch, const Task::Config &task);
+    void detach(const Entry &entry);
+    bool takeQueued(Entry &entry);
+    bool takeNext(Entry &entry);
+    void defer(const Entry &entry);
+    void startWorkers();
+    void runWorker();
+
+private:
+    ResultQueue * const m_results;
+    QThreadPool m_pool;
+
+    mutable QMutex m_mutex;
+    QVector<Batch> m_batches;
+    // Queued tasks by file, so they are found without scanning the queues.
+    QHash<TreeItem*, Entry> m_tasks;
+    // Files with prioritized tasks. Skipped the same way as in batch queues.
+    QQueue<TreeItem*> m_priorityQueue;
+    int m_prioritized = 0;
+    // Files that are being processed right now.
+    QSet<TreeItem*> m_running;
+    // Tasks for running files. Only the latest one is kept per file.
+    QHash<TreeItem*, Entry> m_deferred;
+    // Including deferred tasks.
+    int m_queued = 0;
+    int m_nextBatchId = 1;
+    int m_workers = 0;
+    bool m_paused = false;
+};
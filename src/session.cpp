@@ -0,0 +1,113 @@
+/****************************************************************************
+**
+** SVG Cleaner could help you to clean up your SVG files
+** from unnecessary data.
+** Copyright (C) 2012-2018 Evgeniy Reizner
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License along
+** with this program; if not, write to the Free Software Foundation, Inc.,
+** 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+**
+****************************************************************************/
+
+#include <QDateTime>
+#include <QDir>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+#include "treemodel.h"
+#include "session.h"
+
+static const quint32 Magic = 0x53564753; // SVGS
+static const quint16 Version = 2;
+
+QString Session::filePath()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/session.dat";
+}
+
+bool Session::save(const TreeModel *model)
+{
+    const QString path = filePath();
+
+    if (model->isEmpty()) {
+        QFile::remove(path);
+        return true;
+    }
+
+    QDir().mkpath(QFileInfo(path).absolutePath());
+
+    QSaveFile file(path);
+    if (!file.open(QFile::WriteOnly)) {
+        return false;
+    }
+
+    QDataStream out(&file);
+    out.setVersion(QDataStream::Qt_5_6);
+    out << Magic << Version;
+    model->save(out);
+
+    if (out.status() != QDataStream::Ok) {
+        file.cancelWriting();
+        return false;
+    }
+
+    return file.commit();
+}
+
+bool Session::restore(TreeModel *model)
+{
+    QFile file(filePath());
+    if (!file.open(QFile::ReadOnly)) {
+        return false;
+    }
+
+    QDataStream in(&file);
+    in.setVersion(QDataStream::Qt_5_6);
+
+    quint32 magic = 0;
+    quint16 version = 0;
+    in >> magic >> version;
+    if (magic != Magic || version != Version) {
+        return false;
+    }
+
+    return model->restore(in);
+}
+
+QVector<Session::FileState> Session::findChanged(const QStringList &paths,
+                                                 const QVector<qint64> &lastModified)
+{
+    Q_ASSERT(paths.size() == lastModified.size());
+
+    QVector<FileState> changed;
+    for (int i = 0; i < paths.size(); ++i) {
+        const QFileInfo fi(paths.at(i));
+
+        FileState state;
+        state.index = i;
+        state.exists = fi.exists();
+        if (state.exists) {
+            state.lastModified = fi.lastModified().toMSecsSinceEpoch();
+            if (state.lastModified == lastModified.at(i)) {
+                continue;
+            }
+            state.size = fi.size();
+        }
+
+        changed << state;
+    }
+
+    return changed;
+}
@@ -0,0 +1,48 @@
+/****************************************************************************
+**
+** SVG Cleaner could help you to clean up your SVG files
+** from unnecessary data.
+** Copyright (C) 2012-2018 Evgeniy Reizner
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License along
+** with this program; if not, write to the Free Software Foundation, Inc.,
+** 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+**
+****************************************************************************/
+
+#pragma once
+
+#include <QStringList>
+#include <QVector>
+
+class TreeModel;
+
+// The files tree is saved on exit and restored on startup,
+// so the previous list and its results are not lost.
+namespace Session
+{
+    struct FileState
+    {
+        int index = 0; // in the list passed to findChanged()
+        bool exists = false;
+        qint64 size = 0;
+        qint64 lastModified = 0;
+    };
+
+    QString filePath();
+    bool save(const TreeModel *model);
+    bool restore(TreeModel *model);
+
+    // Checks files by modification time. Can be called from any thread.
+    QVector<FileState> findChanged(const QStringList &paths, const QVector<qint64> &lastModified);
+}
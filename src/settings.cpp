@@ -42,6 +42,16 @@ namespace SettingKey
     const QString Compressor            = "Compressor";
     const QString CompressionLevel      = "CompressionLevel";
     const QString CompressOnlySvgz      = "CompressOnlySvgz";
+    const QString BestOfCompressors     = "BestOfCompressors";
+    const QString BlockCompression      = "BlockCompression";
+    const QString BlockThreshold        = "BlockThreshold";
+    const QString Sidecars              = "Sidecars";
+    const QString SidecarFormats        = "SidecarFormats";
+    const QString SidecarThreshold      = "SidecarThreshold";
+    const QString UseDictionary         = "UseDictionary";
+    const QString ShowTransferSizes     = "ShowTransferSizes";
+    const QString SkipUnchanged         = "SkipUnchanged";
+    const QString UnchangedThreshold    = "UnchangedThreshold";
 
     const QString CheckUpdates          = "CheckUpdates";
     const QString LastUpdatesCheck      = "LastUpdatesCheck";
@@ -80,6 +90,18 @@ QVariant AppSettings::defaultValue(const QString &key)
         hash.insert(SettingKey::Compressor, CompressorName::SevenZip);
         hash.insert(SettingKey::CompressionLevel, 4);
         hash.insert(SettingKey::CompressOnlySvgz, true);
+        hash.insert(SettingKey::BestOfCompressors, QStringList({ CompressorName::SevenZip,
+                                                                 CompressorName::Zopfli,
+                                                                 CompressorName::Deflate }).join(','));
+        hash.insert(SettingKey::BlockCompression, true);
+        hash.insert(SettingKey::BlockThreshold, 4); // MiB
+        hash.insert(SettingKey::Sidecars, false);
+        hash.insert(SettingKey::SidecarFormats, "gz");
+        hash.insert(SettingKey::SidecarThreshold, 5);
+        hash.insert(SettingKey::UseDictionary, false);
+        hash.insert(SettingKey::ShowTransferSizes, false);
+        hash.insert(SettingKey::SkipUnchanged, false);
+        hash.insert(SettingKey::UnchangedThreshold, 16);
         hash.insert(SettingKey::CheckUpdates, true);
     }
 
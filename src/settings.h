@@ -40,6 +40,16 @@ namespace SettingKey
     extern const QString Compressor;
     extern const QString CompressionLevel;
     extern const QString CompressOnlySvgz;
+    extern const QString BestOfCompressors;
+    extern const QString BlockCompression;
+    extern const QString BlockThreshold;
+    extern const QString Sidecars;
+    extern const QString SidecarFormats;
+    extern const QString SidecarThreshold;
+    extern const QString UseDictionary;
+    extern const QString ShowTransferSizes;
+    extern const QString SkipUnchanged;
+    extern const QString UnchangedThreshold;
 
     extern const QString CheckUpdates;
     extern const QString LastUpdatesCheck;
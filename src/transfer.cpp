@@ -0,0 +1,78 @@
+/****************************************************************************
+**
+** SVG Cleaner could help you to clean up your SVG files
+** from unnecessary data.
+** Copyright (C) 2012-2018 Evgeniy Reizner
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License along
+** with this program; if not, write to the Free Software Foundation, Inc.,
+** 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+**
+****************************************************************************/
+
+#include <QCoreApplication>
+
+#ifdef WITH_BROTLI
+#include <brotli/encode.h>
+#endif
+
+#include "gzip.h"
+#include "transfer.h"
+
+static const int GzipLevel = 6;
+static const int BrotliQuality = 5;
+
+bool Transfer::isAvailable() noexcept
+{
+    return Gzip::isAvailable();
+}
+
+bool Transfer::isBrotliAvailable() noexcept
+{
+#ifdef WITH_BROTLI
+    return true;
+#else
+    return false;
+#endif
+}
+
+#ifdef WITH_BROTLI
+static qint64 brotliSize(const QByteArray &data)
+{
+    size_t outSize = BrotliEncoderMaxCompressedSize(size_t(data.size()));
+    QByteArray out(int(outSize), Qt::Uninitialized);
+    const bool ok = BrotliEncoderCompress(
+        BrotliQuality, BROTLI_DEFAULT_WINDOW, BROTLI_MODE_TEXT,
+        size_t(data.size()), reinterpret_cast<const uint8_t*>(data.constData()),
+        &outSize, reinterpret_cast<uint8_t*>(out.data()));
+    if (!ok) {
+        throw QCoreApplication::translate("Transfer", "Failed to compress a file.");
+    }
+
+    return qint64(outSize);
+}
+#endif
+
+Transfer::Sizes Transfer::estimate(const QByteArray &data)
+{
+    Sizes sizes;
+    if (!isAvailable()) {
+        return sizes;
+    }
+
+    sizes.gzip = Gzip::compress(data, GzipLevel).size();
+#ifdef WITH_BROTLI
+    sizes.brotli = brotliSize(data);
+#endif
+    return sizes;
+}
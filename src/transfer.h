@@ -0,0 +1,48 @@
+/****************************************************************************
+**
+** SVG Cleaner could help you to clean up your SVG files
+** from unnecessary data.
+** Copyright (C) 2012-2018 Evgeniy Reizner
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License along
+** with this program; if not, write to the Free Software Foundation, Inc.,
+** 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+**
+****************************************************************************/
+
+#pragma once
+
+#include <QByteArray>
+
+// Estimates how many bytes a file takes on the wire, when a web server
+// compresses it on the fly. Uses gzip level 6, which is the common server default,
+// and Brotli level 5, when built with WITH_BROTLI.
+//
+// Gzip estimates are available only when built with WITH_ZLIB or WITH_LIBDEFLATE.
+namespace Transfer
+{
+    struct Sizes
+    {
+        qint64 gzip = 0;
+        // Zero when Brotli is not available.
+        qint64 brotli = 0;
+
+        bool isEmpty() const { return gzip == 0; }
+    };
+
+    bool isAvailable() noexcept;
+    bool isBrotliAvailable() noexcept;
+
+    // Throws a QString on error.
+    Sizes estimate(const QByteArray &data);
+}
@@ -21,7 +21,14 @@
 ****************************************************************************/
 
 #include <QApplication>
+#include <QDateTime>
 #include <QDir>
+#include <QPainter>
+#include <QScreen>
+#include <QtConcurrent/QtConcurrentRun>
+
+#include <algorithm>
+#include <new>
 
 #include "iconutils.h"
 #include "utils.h"
@@ -30,6 +37,59 @@
 // This model is mostly bad. I still can't understand how a tree model should be implemented.
 // Especially indexes.
 
+// Children are exposed to the view in batches via canFetchMore()/fetchMore(),
+// so huge folders do not force the view to lay out every row.
+static const int FetchBatchSize = 256;
+
+static quint64 atlasKey(Status status, int size, qreal ratio, bool isEnabled)
+{
+    return    quint64(status)
+           | (quint64(isEnabled) << 8)
+           | (quint64(size) << 16)
+           | (quint64(qRound(ratio * 100)) << 32);
+}
+
+StatusDelegate::StatusDelegate(QObject *parent)
+    : QStyledItemDelegate(parent)
+{
+    // A pixel ratio can be changed only with a screen, so the atlas will be rebuilt on demand.
+    connect(qApp, &QGuiApplication::screenAdded, this, [this](){ m_atlas.clear(); });
+    connect(qApp, &QGuiApplication::screenRemoved, this, [this](){ m_atlas.clear(); });
+    connect(qApp, &QGuiApplication::primaryScreenChanged, this, [this](){ m_atlas.clear(); });
+}
+
+void StatusDelegate::buildAtlas(int size, qreal ratio) const
+{
+    const QVector<QPair<Status, QString>> icons = {
+        { Status::Ok,        ":/check.svgz" },
+        { Status::Warning,   ":/warning.svgz" },
+        { Status::Error,     ":/error.svgz" },
+        { Status::Unchanged, ":/unchanged.svgz" },
+    };
+
+    QStyleOption opt;
+    for (const auto &icon : icons) {
+        const QPixmap pix = IconUtils::renderIcon(icon.second, size, ratio);
+        m_atlas.insert(atlasKey(icon.first, size, ratio, true), pix);
+
+        QPixmap disabledPix = QApplication::style()->generatedIconPixmap(QIcon::Disabled, pix, &opt);
+        disabledPix.setDevicePixelRatio(ratio);
+        m_atlas.insert(atlasKey(icon.first, size, ratio, false), disabledPix);
+    }
+}
+
+QPixmap StatusDelegate::statusPixmap(Status status, int size, qreal ratio, bool isEnabled) const
+{
+    const quint64 key = atlasKey(status, size, ratio, isEnabled);
+    auto it = m_atlas.constFind(key);
+    if (it == m_atlas.constEnd()) {
+        buildAtlas(size, ratio);
+        it = m_atlas.constFind(key);
+    }
+
+    return it.value();
+}
+
 void StatusDelegate::paint(QPainter *p, const QStyleOptionViewItem &opt,
                            const QModelIndex &index) const
 {
@@ -40,190 +100,357 @@ void StatusDelegate::paint(QPainter *p, const QStyleOptionViewItem &opt,
     auto iconL = opt.fontMetrics.height();
     iconL -= iconL % 2;
     const auto offset = (opt.rect.height() - iconL) / 2;
-    const auto iconRect = QRect(opt.rect.x() + offset, opt.rect.y() + offset, iconL, iconL);
+    const auto iconPos = QPoint(opt.rect.x() + offset, opt.rect.y() + offset);
 
     const Status status = (Status)index.data().toInt();
 
-    QPixmap pix;
-
-    switch (status) {
-        case Status::None    : break;
-        case Status::Ok      : pix = IconUtils::renderIcon(":/check.svgz", iconL); break;
-        case Status::Warning : pix = IconUtils::renderIcon(":/warning.svgz", iconL); break;
-        case Status::Error   : pix = IconUtils::renderIcon(":/error.svgz", iconL); break;
-    }
-
     QStyle *style = QApplication::style();
     style->drawControl(QStyle::CE_ItemViewItem, &opt, p, opt.widget);
 
-    if (!pix.isNull()) {
-        // We are using pixmap and now just a path to the icon because it's much faster.
-        QIcon icon(pix);
-        QIcon::Mode mode = index.flags() & Qt::ItemIsEnabled ? QIcon::Normal : QIcon::Disabled;
-        icon.paint(p, iconRect, Qt::AlignCenter, mode);
+    if (status != Status::None) {
+        // Use the pixel ratio of the actual paint device and not of the first screen.
+        const qreal ratio = p->device()->devicePixelRatioF();
+        const bool isEnabled = index.flags() & Qt::ItemIsEnabled;
+        p->drawPixmap(iconPos, statusPixmap(status, iconL, ratio, isEnabled));
     }
 }
 
-TreeItem::TreeItem(const QString &path, TreeItem *parent)
-    : m_parentItem(parent)
+void FolderStats::add(const FolderStats &other, int sign)
 {
-    QFileInfo fi(path);
-    if (fi.isDir()) {
-        m_d.title = QDir(path).dirName();
-        m_d.isFolder = true;
-    } else if (fi.isFile()) {
-        m_d.title = fi.fileName();
+    sizeBefore += sign * other.sizeBefore;
+    processedSizeBefore += sign * other.processedSizeBefore;
+    sizeAfter += sign * other.sizeAfter;
+    fileCount += sign * other.fileCount;
+    for (int i = 0; i < StatusCount; ++i) {
+        statusCount[i] += sign * other.statusCount[i];
     }
+    transferBefore.gzip += sign * other.transferBefore.gzip;
+    transferBefore.brotli += sign * other.transferBefore.brotli;
+    transferAfter.gzip += sign * other.transferAfter.gzip;
+    transferAfter.brotli += sign * other.transferAfter.brotli;
+}
 
-    setSizeBefore(QFile(path).size());
+TreeItem::TreeItem(const QString &name, bool isFolder, qint64 size, TreeItem *parent)
+    : m_parentItem(parent)
+    , m_stats(isFolder ? new FolderStats() : nullptr)
+    , m_name(name)
+{
+    m_d.isFolder = isFolder;
+    m_d.sizeBefore = size;
+}
 
-    m_d.path = path;
-    m_checkState = Qt::Checked;
+QString TreeItem::title() const
+{
+    if (m_parentItem && !m_parentItem->m_parentItem) {
+        return m_name.mid(m_name.lastIndexOf('/') + 1);
+    }
+    return m_name;
 }
 
-TreeItem::~TreeItem()
+QString TreeItem::path() const
 {
-    qDeleteAll(m_childItems);
+    if (!m_parentItem || !m_parentItem->m_parentItem) {
+        return m_name;
+    }
+    return m_parentItem->path() + '/' + m_name;
 }
 
 bool TreeItem::appendChild(TreeItem *item)
 {
+    item->m_row = m_childItems.size();
     m_childItems.append(item);
+    addToStats(item->contribution());
     return true;
 }
 
+void TreeItem::collectFiles(QVector<TreeItem*> &files)
+{
+    for (TreeItem *child : m_childItems) {
+        if (child->isFolder()) {
+            child->collectFiles(files);
+        } else {
+            files << child;
+        }
+    }
+}
+
+void TreeItem::removeChildren(int first, int count)
+{
+    FolderStats delta;
+    for (int i = first; i < first + count; ++i) {
+        delta.add(m_childItems.at(i)->contribution(), -1);
+    }
+
+    m_childItems.remove(first, count);
+    for (int i = first; i < m_childItems.size(); ++i) {
+        m_childItems.at(i)->m_row = i;
+    }
+
+    addToStats(delta);
+}
+
 void TreeItem::removeChildren()
 {
-    qDeleteAll(m_childItems);
     m_childItems.clear();
+
+    if (isFolder()) {
+        *m_stats = FolderStats();
+        m_d.sizeBefore = 0;
+        m_d.sizeAfter = 0;
+        m_d.ratio = 0;
+        m_d.transferBefore = Transfer::Sizes();
+        m_d.transferAfter = Transfer::Sizes();
+        m_d.transferRatio = 0;
+    }
 }
 
-FolderStats TreeItem::calcFolderStats()
+// What this item adds to the stats of its parent.
+FolderStats TreeItem::contribution() const
 {
-    Q_ASSERT(isFolder() == true);
+    if (m_checkState != Qt::Checked) {
+        return FolderStats();
+    }
+
+    if (isFolder()) {
+        return *m_stats;
+    }
 
     FolderStats stats;
+    stats.sizeBefore = m_d.sizeBefore;
+    stats.fileCount = 1;
+    stats.statusCount[int(m_d.status)] = 1;
+    if (m_d.status != Status::None) {
+        stats.processedSizeBefore = m_d.sizeBefore;
+        // use original size on error
+        stats.sizeAfter = m_d.status == Status::Error ? m_d.sizeBefore : m_d.sizeAfter;
+    }
+    if (m_d.status != Status::Error) {
+        stats.transferBefore = m_d.transferBefore;
+        stats.transferAfter = m_d.transferAfter;
+    }
 
-    for (TreeItem *child : childrenList()) {
-        if (!child->isEnabled() || child->checkState() != Qt::Checked) {
-            continue;
-        }
+    return stats;
+}
 
-        if (child->isFolder()) {
-            FolderStats childStats = child->calcFolderStats();
-            stats.sizeBefore += childStats.sizeBefore;
-            stats.sizeAfter += childStats.sizeAfter;
-        } else {
-            const TreeItemData &d = child->data();
-            stats.sizeBefore += d.sizeBefore;
-            if (d.status != Status::Error) {
-                stats.sizeAfter += d.sizeAfter;
-            } else {
-                // use original size on error
-                stats.sizeAfter += d.sizeBefore;
-            }
+// Adds stats to this folder and all its parents.
+// Stops at the first unchecked folder, because its contribution doesn't change.
+void TreeItem::addToStats(const FolderStats &stats)
+{
+    for (TreeItem *item = this; item; item = item->m_parentItem) {
+        Q_ASSERT(item->isFolder());
+
+        item->m_stats->add(stats);
+
+        const FolderStats &s = *item->m_stats;
+        item->m_d.sizeBefore = s.sizeBefore;
+        item->m_d.sizeAfter = s.sizeAfter;
+        item->m_d.ratio = s.processedSizeBefore > 0
+                          ? Utils::cleanerRatio(s.processedSizeBefore, s.sizeAfter)
+                          : 0;
+        item->m_d.transferBefore = s.transferBefore;
+        item->m_d.transferAfter = s.transferAfter;
+        item->m_d.transferRatio = s.transferBefore.gzip > 0
+                                  ? Utils::cleanerRatio(s.transferBefore.gzip, s.transferAfter.gzip)
+                                  : 0;
+
+        if (item->m_checkState != Qt::Checked || !item->isAttached()) {
+            break;
         }
     }
+}
 
-    setSizeBefore(stats.sizeBefore);
-    setSizeAfter(stats.sizeAfter);
-    setRatio(Utils::cleanerRatio(stats.sizeBefore, stats.sizeAfter));
+// Items are created with a parent, but appended to it only after their own
+// children were scanned. Until then, stats must not reach the parent.
+bool TreeItem::isAttached() const
+{
+    return m_parentItem
+           && m_row < m_parentItem->m_childItems.size()
+           && m_parentItem->m_childItems.at(m_row) == this;
+}
 
-    return stats;
+void TreeItem::updateParents(const FolderStats &oldContribution)
+{
+    if (!isAttached()) {
+        return;
+    }
+
+    FolderStats delta = contribution();
+    delta.add(oldContribution, -1);
+    m_parentItem->addToStats(delta);
 }
 
-bool TreeItem::hasFolderStats() const
+void TreeItem::setCheckState(Qt::CheckState state)
 {
-    return isFolder() && m_d.sizeAfter > 0;
+    const FolderStats old = contribution();
+    m_checkState = state;
+    updateParents(old);
 }
 
-QString TreeItem::prepareSize(qint64 bytes)
+bool TreeItem::isEnabled() const
 {
-    const qint64 kb = 1024;
-    const qint64 mb = 1024 * kb;
-    if (bytes >= mb) {
-        return TreeModel::tr("%1 MiB").arg(QLocale().toString(qreal(bytes) / mb, 'f', 2));
-    }
-    if (bytes >= kb) {
-        return TreeModel::tr("%1 KiB").arg(QLocale().toString(qreal(bytes) / kb, 'f', 2));
+    for (const TreeItem *item = m_parentItem; item; item = item->m_parentItem) {
+        if (item->m_checkState != Qt::Checked) {
+            return false;
+        }
     }
-    return TreeModel::tr("%1 B").arg(QLocale().toString(bytes));
+
+    return true;
 }
 
 void TreeItem::setSizeBefore(qint64 bytes)
 {
+    const FolderStats old = contribution();
     m_d.sizeBefore = bytes;
-    m_d.sizeBeforeText = prepareSize(bytes);
+    updateParents(old);
 }
 
 void TreeItem::setSizeAfter(qint64 bytes)
 {
+    const FolderStats old = contribution();
     m_d.sizeAfter = bytes;
-    m_d.sizeAfterText = prepareSize(bytes);
+    updateParents(old);
 }
 
-void TreeItem::setRatio(float ratio)
+void TreeItem::setStatus(Status status)
 {
-    m_d.ratio = ratio;
-    m_d.ratioText = QLocale().toString(ratio, 'f', 2) + '%';
+    const FolderStats old = contribution();
+    m_d.status = status;
+    updateParents(old);
+}
+
+bool TreeItem::hasFolderStats() const
+{
+    return isFolder() && m_d.sizeAfter > 0;
 }
 
 void TreeItem::resetCleanerData()
 {
+    const FolderStats old = contribution();
     m_d.outPath.clear();
-
     m_d.sizeAfter = 0;
-    m_d.sizeAfterText.clear();
-
     m_d.ratio = 0;
-    m_d.ratioText.clear();
-
     m_d.status = Status::None;
     m_d.statusText.clear();
+    m_d.zipType = Compressor::None;
+    m_d.zipIterations = 0;
+    m_d.zipGain = 0;
+    m_d.artifacts.clear();
+    m_d.transferBefore = Transfer::Sizes();
+    m_d.transferAfter = Transfer::Sizes();
+    m_d.transferRatio = 0;
+    updateParents(old);
+}
+
+void TreeItem::setTransferSizes(const Transfer::Sizes &before, const Transfer::Sizes &after)
+{
+    const FolderStats old = contribution();
+    m_d.transferBefore = before;
+    m_d.transferAfter = after;
+    m_d.transferRatio = before.gzip > 0 ? Utils::cleanerRatio(before.gzip, after.gzip) : 0;
+    updateParents(old);
 }
 
-int TreeItem::row() const
+void TreeItem::setOutputPath(const QString &path)
 {
-    if (m_parentItem) {
-        return m_parentItem->m_childItems.indexOf(const_cast<TreeItem*>(this));
+    const QString p = QDir::fromNativeSeparators(path);
+
+    // names of top-level items are absolute paths already
+    if (m_parentItem && m_parentItem->m_parentItem) {
+        const int idx = p.lastIndexOf('/');
+        if (idx != -1 && p.leftRef(idx) == m_parentItem->path()) {
+            const QStringRef name = p.midRef(idx + 1);
+            m_d.outPath = (name == m_name) ? m_name : name.toString();
+            return;
+        }
     }
-    return 0;
+
+    m_d.outPath = p;
+}
+
+QString TreeItem::outputPath() const
+{
+    if (m_d.outPath.isEmpty() || m_d.outPath.contains('/')) {
+        return m_d.outPath;
+    }
+
+    return m_parentItem->path() + '/' + m_d.outPath;
+}
+
+bool TreeItem::isOwnOutput(const QString &path, qint64 size) const
+{
+    return m_d.sizeAfter == size && outputPath() == path;
+}
+
+void TreeItem::setZipStats(const Compressor::Stats &stats)
+{
+    m_d.zipType = stats.type;
+    m_d.zipIterations = stats.iterations;
+    m_d.zipGain = int(stats.gain);
 }
 
 Qt::ItemFlags TreeItem::flags() const
 {
     Qt::ItemFlags currFlags = Qt::ItemIsEnabled | Qt::ItemIsUserCheckable;
-    if (!m_isEnabled) {
+    if (!isEnabled()) {
         currFlags &= ~(Qt::ItemIsEnabled);
     }
     return currFlags;
 }
 
-bool TreeItem::hasChild(const QString &path) const
+TreeItemArena::~TreeItemArena()
 {
-    for (TreeItem *child : childrenList()) {
-        if (child->data().path == path) {
-            return true;
-        }
+    QSet<TreeItem*> freeItems;
+    for (TreeItem *item : m_freeItems) {
+        freeItems.insert(item);
+    }
 
-        if (child->isFolder()) {
-            if (child->hasChild(path)) {
-                return true;
+    for (int i = 0; i < m_blocks.size(); ++i) {
+        TreeItem *block = m_blocks.at(i);
+        const int count = (i == m_blocks.size() - 1) ? m_blockUsed : BlockSize;
+        for (int j = 0; j < count; ++j) {
+            if (!freeItems.contains(block + j)) {
+                block[j].~TreeItem();
             }
         }
+
+        ::operator delete(block);
     }
+}
 
-    return false;
+TreeItem *TreeItemArena::create(const QString &name, bool isFolder, qint64 size, TreeItem *parent)
+{
+    void *mem = nullptr;
+    if (!m_freeItems.isEmpty()) {
+        mem = m_freeItems.takeLast();
+    } else {
+        if (m_blockUsed == BlockSize) {
+            m_blocks << static_cast<TreeItem*>(::operator new(sizeof(TreeItem) * BlockSize));
+            m_blockUsed = 0;
+        }
+        mem = m_blocks.last() + m_blockUsed++;
+    }
+
+    return new (mem) TreeItem(name, isFolder, size, parent);
+}
+
+void TreeItemArena::destroy(TreeItem *item)
+{
+    item->~TreeItem();
+    m_freeItems << item;
 }
 
 TreeModel::TreeModel(QObject *parent)
     : QAbstractItemModel(parent)
-    ,  m_rootItem(new TreeItem("Root"))
+    , m_arena(new TreeItemArena())
+    , m_rootItem(new TreeItem("Root", true, 0))
+    , m_sizeTexts(512)
+    , m_ratioTexts(512)
 {
 }
 
 TreeModel::~TreeModel()
 {
+    delete m_arena;
     delete m_rootItem;
 }
 
@@ -242,7 +469,8 @@ QVariant TreeModel::data(const QModelIndex &index, int role) const
 
     if (role == Qt::ToolTipRole) {
         if (index.column() == Column::Status) {
-            if (d.status == Status::Warning || d.status == Status::Error) {
+            if (   d.status == Status::Warning || d.status == Status::Error
+                || d.status == Status::Unchanged) {
                 return   d.statusText + "\n\n"
                        + tr("Double-click to show this text in a message box.");
             }
@@ -253,20 +481,51 @@ QVariant TreeModel::data(const QModelIndex &index, int role) const
         }
 
         if (index.column() == Column::SizeAfter
-                && (d.status == Status::Ok || d.status == Status::Warning)) {
-            return tr("Double-click to open an output file.");
+                && (   d.status == Status::Ok || d.status == Status::Warning
+                    || d.status == Status::Unchanged)) {
+            QString text;
+            if (d.zipType != Compressor::None) {
+                text += tr("Compressed by %1.").arg(Compressor(d.zipType).name()) + "\n";
+            }
+            if (d.zipIterations > 0) {
+                text +=   tr("Zopfli: %n iteration(s)", "", d.zipIterations) + ", "
+                        + tr("%1 saved by extra iterations.").arg(sizeText(d.zipGain)) + "\n";
+            }
+            if (!d.artifacts.isEmpty()) {
+                text += tr("Written files:") + "\n";
+                for (const Task::Output::Artifact &artifact : d.artifacts) {
+                    text += QString("%1 (%2)\n").arg(QFileInfo(artifact.path).fileName(),
+                                                    sizeText(artifact.size));
+                }
+            }
+            if (!text.isEmpty()) {
+                text += "\n";
+            }
+            return text + tr("Double-click to open an output file.");
+        }
+
+        if (index.column() == Column::TransferBefore && !d.transferBefore.isEmpty()) {
+            return transferToolTip(d.transferBefore);
+        }
+
+        if (index.column() == Column::TransferAfter && !d.transferAfter.isEmpty()) {
+            return transferToolTip(d.transferAfter);
         }
     }
 
     if (role == Qt::TextAlignmentRole) {
         if (   index.column() == Column::SizeBefore
             || index.column() == Column::SizeAfter
-            || index.column() == Column::Ratio)
+            || index.column() == Column::Ratio
+            || index.column() == Column::TransferBefore
+            || index.column() == Column::TransferAfter
+            || index.column() == Column::TransferRatio)
         return QVariant(Qt::AlignRight | Qt::AlignVCenter);
     }
 
     if (role == Qt::ForegroundRole && index.column() == Column::Ratio) {
-        if (d.status == Status::Ok || d.status == Status::Warning || item->hasFolderStats()) {
+        if (   d.status == Status::Ok || d.status == Status::Warning
+            || d.status == Status::Unchanged || item->hasFolderStats()) {
             QColor c;
             if (d.ratio >= 40.0f) {
                 c = QColor(0, 168, 119);
@@ -289,8 +548,8 @@ QVariant TreeModel::data(const QModelIndex &index, int role) const
     }
 
     switch (index.column()) {
-        case Column::Name : return d.title;
-        case Column::SizeBefore : return d.sizeBeforeText;
+        case Column::Name : return item->title();
+        case Column::SizeBefore : return sizeText(d.sizeBefore);
         case Column::Status : return (int)d.status;
         default: break;
     }
@@ -301,10 +560,20 @@ QVariant TreeModel::data(const QModelIndex &index, int role) const
 
     const bool isShowFolderStats = item->isFolder() && d.sizeAfter > 0;
 
-    if (d.status == Status::Ok || d.status == Status::Warning || isShowFolderStats) {
+    if (   d.status == Status::Ok || d.status == Status::Warning
+        || d.status == Status::Unchanged || isShowFolderStats) {
         switch (index.column()) {
-            case Column::SizeAfter : return d.sizeAfterText;
-            case Column::Ratio : return d.ratioText;
+            case Column::SizeAfter : return sizeText(d.sizeAfter);
+            case Column::Ratio : return ratioText(d.ratio);
+            default: break;
+        }
+    }
+
+    if (!d.transferBefore.isEmpty()) {
+        switch (index.column()) {
+            case Column::TransferBefore : return sizeText(d.transferBefore.gzip);
+            case Column::TransferAfter : return sizeText(d.transferAfter.gzip);
+            case Column::TransferRatio : return ratioText(d.transferRatio);
             default: break;
         }
     }
@@ -312,33 +581,85 @@ QVariant TreeModel::data(const QModelIndex &index, int role) const
     return QVariant();
 }
 
-static void setCheckToChildren(Qt::CheckState state, TreeItem *parent)
+static QString prepareSize(qint64 bytes)
 {
-    for (TreeItem *child : parent->childrenList()) {
-        child->setEnabled(state == Qt::Checked);
-        if (child->hasChildren() && child->checkState() == Qt::Checked) {
-            setCheckToChildren(state, child);
-        }
+    const qint64 kb = 1024;
+    const qint64 mb = 1024 * kb;
+    if (bytes >= mb) {
+        return TreeModel::tr("%1 MiB").arg(QLocale().toString(qreal(bytes) / mb, 'f', 2));
+    }
+    if (bytes >= kb) {
+        return TreeModel::tr("%1 KiB").arg(QLocale().toString(qreal(bytes) / kb, 'f', 2));
+    }
+    return TreeModel::tr("%1 B").arg(QLocale().toString(bytes));
+}
+
+QString TreeModel::sizeText(qint64 bytes) const
+{
+    if (QString *text = m_sizeTexts.object(bytes)) {
+        return *text;
+    }
+
+    const QString text = prepareSize(bytes);
+    m_sizeTexts.insert(bytes, new QString(text));
+    return text;
+}
+
+QString TreeModel::ratioText(float ratio) const
+{
+    // the ratio is shown with two decimals, so it's a good key
+    const int key = qRound(ratio * 100);
+    if (QString *text = m_ratioTexts.object(key)) {
+        return *text;
+    }
+
+    const QString text = QLocale().toString(ratio, 'f', 2) + '%';
+    m_ratioTexts.insert(key, new QString(text));
+    return text;
+}
+
+QString TreeModel::transferToolTip(const Transfer::Sizes &sizes) const
+{
+    QString text = tr("gzip: %1").arg(sizeText(sizes.gzip));
+    if (sizes.brotli > 0) {
+        text += "\n" + tr("Brotli: %1").arg(sizeText(sizes.brotli));
     }
+    return text;
 }
 
 bool TreeModel::setData(const QModelIndex &index, const QVariant &value, int role)
 {
-    if (role == Qt::CheckStateRole && index.column() == 0) {
+    if (role == Qt::CheckStateRole && index.column() == 0 && !m_isChecksLocked) {
         TreeItem *item = static_cast<TreeItem*>(index.internalPointer());
-        if (value.toInt() == 0) {
-            item->setCheckState(Qt::Unchecked);
-            setCheckToChildren(Qt::Unchecked, item);
-        } else {
-            item->setCheckState(Qt::Checked);
-            setCheckToChildren(Qt::Checked, item);
-        }
+        item->setCheckState(value.toInt() == 0 ? Qt::Unchecked : Qt::Checked);
         itemEditFinished(item);
-        calcFoldersStats();
+
+        // children are enabled/disabled now
+        if (item->isFolder()) {
+            subtreeChanged(item);
+        }
     }
     return true;
 }
 
+void TreeModel::subtreeChanged(TreeItem *parent)
+{
+    const int rows = parent->fetchedCount();
+    if (rows == 0) {
+        return;
+    }
+
+    emit dataChanged(createIndex(0, 0, parent->child(0)),
+                     createIndex(rows - 1, columnCount() - 1, parent->child(rows - 1)));
+
+    for (int row = 0; row < rows; ++row) {
+        TreeItem *child = parent->child(row);
+        if (child->isFolder()) {
+            subtreeChanged(child);
+        }
+    }
+}
+
 Qt::ItemFlags TreeModel::flags(const QModelIndex &index) const
 {
     if (!index.isValid()) {
@@ -346,7 +667,11 @@ Qt::ItemFlags TreeModel::flags(const QModelIndex &index) const
     }
 
     TreeItem *item = static_cast<TreeItem*>(index.internalPointer());
-    return item->flags();
+    Qt::ItemFlags flags = item->flags();
+    if (m_isChecksLocked) {
+        flags &= ~Qt::ItemIsUserCheckable;
+    }
+    return flags;
 }
 
 QVariant TreeModel::headerData(int section, Qt::Orientation orientation, int role) const
@@ -357,11 +682,19 @@ QVariant TreeModel::headerData(int section, Qt::Orientation orientation, int rol
             case Column::SizeBefore :   return tr("Size before");
             case Column::SizeAfter :    return tr("Size after");
             case Column::Ratio :        return tr("Ratio");
+            case Column::TransferBefore : return tr("Transfer before");
+            case Column::TransferAfter :  return tr("Transfer after");
+            case Column::TransferRatio :  return tr("Transfer ratio");
             case Column::Status :       return tr("Status");
         default: break;
         }
     }
 
+    if (   orientation == Qt::Horizontal && role == Qt::ToolTipRole
+        && section >= Column::TransferBefore && section <= Column::TransferRatio) {
+        return tr("Estimated size of the SVG when a web server compresses it with gzip.");
+    }
+
     return QVariant();
 }
 
@@ -379,7 +712,7 @@ QModelIndex TreeModel::index(int row, int column, const QModelIndex &parent) con
         parentItem = static_cast<TreeItem*>(parent.internalPointer());
     }
 
-    TreeItem *childItem = parentItem->child(row);
+    TreeItem *childItem = row < parentItem->fetchedCount() ? parentItem->child(row) : nullptr;
     if (childItem) {
         return createIndex(row, column, childItem);
     } else {
@@ -421,7 +754,7 @@ int TreeModel::rowCount(const QModelIndex &parent) const
         parentItem = static_cast<TreeItem*>(parent.internalPointer());
     }
 
-    return parentItem->childCount();
+    return parentItem->fetchedCount();
 }
 
 int TreeModel::columnCount(const QModelIndex &) const
@@ -429,25 +762,141 @@ int TreeModel::columnCount(const QModelIndex &) const
     return Column::LastColumn;
 }
 
-TreeModel::AddResult TreeModel::addFolder(const QString &path)
+bool TreeModel::hasChildren(const QModelIndex &parent) const
 {
-    if (rootItem()->hasChild(path)) {
-        return AddResult::FolderExists;
+    if (parent.column() > 0) {
+        return false;
     }
 
-    TreeItem *dirItem = new TreeItem(path, rootItem());
-    scanFolder(path, dirItem);
+    TreeItem *parentItem = parent.isValid() ? itemByIndex(parent) : m_rootItem;
+    return parentItem->hasChildren();
+}
 
-    if (dirItem->hasChildren()) {
-        rootItem()->appendChild(dirItem);
-    } else {
-        delete dirItem;
-        return AddResult::Empty;
+bool TreeModel::canFetchMore(const QModelIndex &parent) const
+{
+    if (parent.column() > 0) {
+        return false;
     }
 
-    return AddResult::Ok;
+    TreeItem *parentItem = parent.isValid() ? itemByIndex(parent) : m_rootItem;
+    return parentItem->canFetchMore();
 }
 
+void TreeModel::fetchMore(const QModelIndex &parent)
+{
+    TreeItem *parentItem = parent.isValid() ? itemByIndex(parent) : m_rootItem;
+
+    const int first = parentItem->fetchedCount();
+    const int last = qMin(first + FetchBatchSize, parentItem->childCount()) - 1;
+    if (last < first) {
+        return;
+    }
+
+    beginInsertRows(parent, first, last);
+    parentItem->setFetchedCount(last + 1);
+    endInsertRows();
+}
+
+static bool hasUnfetchedItems(TreeItem *parent)
+{
+    if (parent->canFetchMore()) {
+        return true;
+    }
+
+    for (TreeItem *child : parent->childrenList()) {
+        if (child->isFolder() && hasUnfetchedItems(child)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static void fetchAllItems(TreeItem *parent)
+{
+    parent->setFetchedCount(parent->childCount());
+    for (TreeItem *child : parent->childrenList()) {
+        if (child->isFolder()) {
+            fetchAllItems(child);
+        }
+    }
+}
+
+// Sorting and filtering proxies can see only fetched rows,
+// so they should request the whole tree first.
+void TreeModel::fetchAll()
+{
+    if (!hasUnfetchedItems(m_rootItem)) {
+        return;
+    }
+
+    beginResetModel();
+    fetchAllItems(m_rootItem);
+    endResetModel();
+}
+
+// Adds files and folders in one pass. Duplicates are checked using the index
+// and all new top-level items are inserted with a single model signal.
+TreeModel::AddSummary TreeModel::addPaths(const QStringList &paths)
+{
+    AddSummary summary;
+    QVector<TreeItem*> newItems;
+
+    for (const QString &p : paths) {
+        const QFileInfo fi(p);
+        if (fi.isSymLink()) {
+            summary.symlinks++;
+            continue;
+        }
+
+        if (fi.isDir()) {
+            const QString path = QDir::cleanPath(p);
+            if (findItem(path)) {
+                summary.duplicates++;
+                continue;
+            }
+
+            const int prevFileCount = m_fileCount;
+
+            TreeItem *dirItem = m_arena->create(path, true, 0, rootItem());
+            scanFolder(path, dirItem);
+
+            if (dirItem->hasChildren()) {
+                addToIndex(dirItem, path);
+                newItems << dirItem;
+                summary.files += m_fileCount - prevFileCount;
+            } else {
+                m_arena->destroy(dirItem);
+                summary.emptyFolders++;
+            }
+        } else if (fi.isFile()) {
+            const QString suffix = fi.suffix().toLower();
+            if (suffix != "svg" && suffix != "svgz") {
+                summary.unsupported++;
+                continue;
+            }
+
+            if (findItem(p)) {
+                summary.duplicates++;
+                continue;
+            }
+
+            TreeItem *item = m_arena->create(p, false, fi.size(), rootItem());
+            item->setLastModified(fi.lastModified().toMSecsSinceEpoch());
+            addToIndex(item, p);
+            newItems << item;
+            m_fileCount++;
+            summary.files++;
+        }
+    }
+
+    appendItems(rootItem(), newItems);
+    summary.items = newItems;
+
+    return summary;
+}
+
+// The folder is not attached to the model yet, so no model signals are needed here.
 void TreeModel::scanFolder(const QString &path, TreeItem *parent)
 {
     static const QStringList filesFilter = { "*.svg", "*.svgz" };
@@ -455,43 +904,352 @@ void TreeModel::scanFolder(const QString &path, TreeItem *parent)
     const auto flags = QDir::Dirs | QDir::NoDotAndDotDot | QDir::NoSymLinks;
     const auto dirInfo = QDir(path).entryInfoList(flags, QDir::Name);
     for (const QFileInfo &fi : dirInfo) {
-        TreeItem *dirItem = new TreeItem(fi.absoluteFilePath(), parent);
-        scanFolder(fi.absoluteFilePath(), dirItem);
+        const QString dirPath = fi.absoluteFilePath();
+        TreeItem *dirItem = m_arena->create(intern(fi.fileName()), true, 0, parent);
+        scanFolder(dirPath, dirItem);
 
         if (dirItem->hasChildren()) {
-            beginInsertRows(index(parent), rowCount(), rowCount());
+            addToIndex(dirItem, dirPath);
             parent->appendChild(dirItem);
-            endInsertRows();
         } else {
             // skip empty folders
-            delete dirItem;
+            m_arena->destroy(dirItem);
         }
     }
 
     for (const QFileInfo &fi : QDir(path).entryInfoList(filesFilter, QDir::Files | QDir::NoSymLinks,
                                                         QDir::Name)) {
-        addFile(fi.absoluteFilePath(), parent);
+        const QString filePath = fi.absoluteFilePath();
+        if (findItem(filePath)) {
+            continue;
+        }
+
+        TreeItem *item = m_arena->create(intern(fi.fileName()), false, fi.size(), parent);
+        item->setLastModified(fi.lastModified().toMSecsSinceEpoch());
+        addToIndex(item, filePath);
+        parent->appendChild(item);
+        m_fileCount++;
     }
+
+    parent->setFetchedCount(qMin(parent->childCount(), FetchBatchSize));
 }
 
-TreeModel::AddResult TreeModel::addFile(const QString &path, TreeItem *parent)
+void TreeModel::addToIndex(TreeItem *item, const QString &path)
 {
-    if (rootItem()->hasChild(path)) {
-        return AddResult::FileExists;
+    m_pathIndex.insert(qHash(path), item);
+}
+
+TreeItem *TreeModel::findItem(const QString &path) const
+{
+    auto it = m_pathIndex.constFind(qHash(path));
+    for (; it != m_pathIndex.constEnd() && it.key() == qHash(path); ++it) {
+        if (it.value()->path() == path) {
+            return it.value();
+        }
     }
 
-    if (!parent) {
-        parent = rootItem();
+    return nullptr;
+}
+
+QString TreeModel::intern(const QString &str)
+{
+    const auto it = m_strings.constFind(str);
+    if (it != m_strings.constEnd()) {
+        return *it;
     }
 
-    beginInsertRows(index(rowCount(), 0, QModelIndex()), rowCount(), rowCount());
+    m_strings.insert(str);
+    return str;
+}
+
+void TreeModel::appendItems(TreeItem *parent, const QVector<TreeItem*> &items)
+{
+    if (items.isEmpty()) {
+        return;
+    }
 
-    TreeItem *item = new TreeItem(path, parent);
-    parent->appendChild(item);
+    const int first = parent->childCount();
 
+    // New rows are shown right away only while the parent is small and fully fetched.
+    // Otherwise they will be fetched by the view on demand.
+    if (parent->canFetchMore() || first >= FetchBatchSize || !isExposed(parent)) {
+        for (TreeItem *item : items) {
+            parent->appendChild(item);
+        }
+        return;
+    }
+
+    const int last = qMin(first + items.size(), FetchBatchSize) - 1;
+    beginInsertRows(parent == m_rootItem ? QModelIndex() : index(parent), first, last);
+    for (TreeItem *item : items) {
+        parent->appendChild(item);
+    }
+    parent->setFetchedCount(last + 1);
     endInsertRows();
+}
+
+// Removes children by sorted rows. One signal is emitted per continuous range of rows.
+void TreeModel::removeItems(TreeItem *parent, const QVector<int> &rows)
+{
+    if (rows.isEmpty()) {
+        return;
+    }
+
+    const QModelIndex parentIndex = parent == m_rootItem ? QModelIndex() : index(parent);
+    const bool exposed = isExposed(parent);
+
+    int end = rows.size();
+    while (end > 0) {
+        int begin = end - 1;
+        while (begin > 0 && rows.at(begin - 1) == rows.at(begin) - 1) {
+            begin--;
+        }
+
+        const int first = rows.at(begin);
+        const int count = end - begin;
+        const int fetched = parent->fetchedCount();
+        const int visible = qMax(0, qMin(first + count, fetched) - first);
+
+        if (exposed && visible > 0) {
+            beginRemoveRows(parentIndex, first, first + visible - 1);
+        }
+
+        QVector<TreeItem*> items;
+        for (int i = first; i < first + count; ++i) {
+            items << parent->child(i);
+        }
+
+        parent->removeChildren(first, count);
+        parent->setFetchedCount(fetched - visible);
+
+        for (TreeItem *item : items) {
+            destroyItem(item);
+        }
+
+        if (exposed && visible > 0) {
+            endRemoveRows();
+        }
+
+        end = begin;
+    }
+
+    m_generation++;
+}
+
+void TreeModel::destroyItem(TreeItem *item)
+{
+    for (TreeItem *child : item->childrenList()) {
+        destroyItem(child);
+    }
+
+    if (!item->isFolder()) {
+        m_fileCount--;
+    }
+
+    m_pathIndex.remove(qHash(item->path()), item);
+    m_arena->destroy(item);
+}
+
+// Whether the view knows about the item, i.e. it and all its parents are fetched.
+bool TreeModel::isExposed(TreeItem *item) const
+{
+    for (; item != m_rootItem; item = item->parent()) {
+        if (item->row() >= item->parent()->fetchedCount()) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// Resets the item when the file was changed. Returns false when it's not a file anymore.
+bool TreeModel::refreshFile(const QFileInfo &fi, TreeItem *item)
+{
+    if (!fi.isFile()) {
+        return false;
+    }
+
+    const TreeItemData &d = item->data();
+    const qint64 lastModified = fi.lastModified().toMSecsSinceEpoch();
+    if (d.sizeBefore == fi.size() && d.lastModified == lastModified) {
+        return false;
+    }
+
+    // the file was overwritten by the cleaner itself
+    if (item->isOwnOutput(fi.absoluteFilePath(), fi.size())) {
+        item->setLastModified(lastModified);
+        return false;
+    }
+
+    item->resetCleanerData();
+    item->setSizeBefore(fi.size());
+    item->setLastModified(lastModified);
+    return true;
+}
+
+TreeModel::RefreshSummary TreeModel::refresh()
+{
+    RefreshSummary summary;
+    const int prevFileCount = m_fileCount;
+
+    QVector<int> removedRows;
+    QVector<TreeItem*> changed;
+    for (TreeItem *item : m_rootItem->childrenList()) {
+        const QFileInfo fi(item->name());
+        if (item->isFolder()) {
+            if (fi.isDir() && !fi.isSymLink()) {
+                syncFolder(item->name(), item, true, true, summary);
+                if (item->hasChildren()) {
+                    continue;
+                }
+            }
+        } else if (fi.isFile()) {
+            if (refreshFile(fi, item)) {
+                changed << item;
+            }
+            continue;
+        }
+
+        removedRows << item->row();
+    }
+
+    removeItems(m_rootItem, removedRows);
+    itemsEditFinished(changed);
+
+    summary.modified += changed.size();
+    summary.changedFiles << changed;
+    summary.removed = prevFileCount + summary.added - m_fileCount;
+
+    return summary;
+}
 
-    return AddResult::Ok;
+// Refreshes only direct children of the folder, so it's cheap enough
+// to be called on each file system event.
+TreeModel::RefreshSummary TreeModel::refreshFolder(const QString &path, bool removeMissing)
+{
+    RefreshSummary summary;
+
+    // A new folder is not in the tree until it has SVG files,
+    // so the nearest known parent is refreshed instead.
+    QString dirPath = QDir::cleanPath(path);
+    TreeItem *folder = findItem(dirPath);
+    while (!folder) {
+        const int idx = dirPath.lastIndexOf('/');
+        if (idx <= 0) {
+            return summary;
+        }
+        dirPath.truncate(idx);
+        folder = findItem(dirPath);
+    }
+
+    if (!folder->isFolder()) {
+        return summary;
+    }
+
+    const int prevFileCount = m_fileCount;
+
+    syncFolder(dirPath, folder, false, removeMissing, summary);
+
+    if (removeMissing) {
+        // remove folders without SVG files
+        while (folder != m_rootItem && !folder->hasChildren()) {
+            TreeItem *parent = folder->parent();
+            removeItems(parent, { folder->row() });
+            folder = parent;
+        }
+    }
+
+    summary.removed = prevFileCount + summary.added - m_fileCount;
+
+    return summary;
+}
+
+// Unchanged items are kept as is, so they keep their results.
+// New items are appended to the end of the folder.
+void TreeModel::syncFolder(const QString &path, TreeItem *folder, bool recursive,
+                           bool removeMissing, RefreshSummary &summary)
+{
+    static const QStringList filesFilter = { "*.svg", "*.svgz" };
+
+    QHash<QString, TreeItem*> oldItems;
+    oldItems.reserve(folder->childCount());
+    for (TreeItem *child : folder->childrenList()) {
+        oldItems.insert(child->name(), child);
+    }
+
+    QVector<TreeItem*> newItems;
+    QVector<TreeItem*> changed;
+
+    const auto flags = QDir::Dirs | QDir::NoDotAndDotDot | QDir::NoSymLinks;
+    for (const QFileInfo &fi : QDir(path).entryInfoList(flags, QDir::Name)) {
+        const QString dirPath = fi.absoluteFilePath();
+
+        TreeItem *item = oldItems.value(fi.fileName());
+        if (item && item->isFolder()) {
+            if (recursive) {
+                syncFolder(dirPath, item, true, removeMissing, summary);
+            }
+            // folders without SVG files are removed below
+            if (item->hasChildren()) {
+                oldItems.remove(fi.fileName());
+            }
+            continue;
+        }
+
+        const int prevFileCount = m_fileCount;
+        TreeItem *dirItem = m_arena->create(intern(fi.fileName()), true, 0, folder);
+        scanFolder(dirPath, dirItem);
+
+        if (dirItem->hasChildren()) {
+            addToIndex(dirItem, dirPath);
+            dirItem->collectFiles(summary.changedFiles);
+            newItems << dirItem;
+            summary.added += m_fileCount - prevFileCount;
+        } else {
+            m_arena->destroy(dirItem);
+        }
+    }
+
+    for (const QFileInfo &fi : QDir(path).entryInfoList(filesFilter, QDir::Files | QDir::NoSymLinks,
+                                                        QDir::Name)) {
+        TreeItem *item = oldItems.value(fi.fileName());
+        if (item && !item->isFolder()) {
+            oldItems.remove(fi.fileName());
+            if (refreshFile(fi, item)) {
+                changed << item;
+            }
+            continue;
+        }
+
+        item = m_arena->create(intern(fi.fileName()), false, fi.size(), folder);
+        item->setLastModified(fi.lastModified().toMSecsSinceEpoch());
+        addToIndex(item, fi.absoluteFilePath());
+        newItems << item;
+        summary.changedFiles << item;
+        m_fileCount++;
+        summary.added++;
+    }
+
+    QVector<int> removedRows;
+    if (removeMissing) {
+        removedRows.reserve(oldItems.size());
+        for (const TreeItem *item : oldItems) {
+            removedRows << item->row();
+        }
+        std::sort(removedRows.begin(), removedRows.end());
+    }
+
+    removeItems(folder, removedRows);
+    appendItems(folder, newItems);
+
+    summary.modified += changed.size();
+    summary.changedFiles << changed;
+
+    // folder stats are changed too
+    if (!changed.isEmpty() || !newItems.isEmpty() || !removedRows.isEmpty()) {
+        changed << folder;
+        itemsEditFinished(changed);
+    }
 }
 
 TreeItem *TreeModel::itemByIndex(const QModelIndex &index) const
@@ -512,42 +1270,207 @@ bool TreeModel::isEmpty() const
     return !rootItem()->hasChildren();
 }
 
-void TreeModel::calcFoldersStats()
+int TreeModel::fileCount() const
 {
-    for (TreeItem *item : rootItem()->childrenList()) {
-        if (item->isFolder()) {
-            item->calcFolderStats();
+    return m_fileCount;
+}
+
+const FolderStats &TreeModel::stats() const
+{
+    return m_rootItem->folderStats();
+}
+
+void TreeModel::itemEditFinished(TreeItem *item)
+{
+    itemsEditFinished({ item });
+}
+
+void TreeModel::itemsEditFinished(const QVector<TreeItem*> &items)
+{
+    // Emit one signal per contiguous run of changed rows instead of one per item.
+    // Runs are not merged, since the view measures every row in a range.
+    // Parent folders are updated too, since their stats are changed.
+    QHash<TreeItem*, QVector<int>> changedRows;
+    QSet<TreeItem*> visited;
+    for (TreeItem *item : items) {
+        for (; item != m_rootItem && !visited.contains(item); item = item->parent()) {
+            visited.insert(item);
+
+            TreeItem *parent = item->parent();
+            const int row = item->row();
+            if (row >= parent->fetchedCount()) {
+                // not fetched yet, so the view doesn't know about it
+                continue;
+            }
+
+            changedRows[parent] << row;
+        }
+    }
+
+    for (auto it = changedRows.begin(); it != changedRows.end(); ++it) {
+        TreeItem *parent = it.key();
+        QVector<int> &rows = it.value();
+        std::sort(rows.begin(), rows.end());
+
+        int first = rows.first();
+        for (int i = 1; i <= rows.size(); ++i) {
+            if (i < rows.size() && rows.at(i) == rows.at(i - 1) + 1) {
+                continue;
+            }
+
+            const int last = rows.at(i - 1);
+            emit dataChanged(createIndex(first, 0, parent->child(first)),
+                             createIndex(last, columnCount() - 1, parent->child(last)));
+            if (i < rows.size()) {
+                first = rows.at(i);
+            }
         }
     }
 }
 
-static int _calcFileCount(TreeItem *item)
+void TreeModel::clear()
 {
-    int c = 0;
-    for (TreeItem *child : item->childrenList()) {
-        if (child->isFolder()) {
-            c += _calcFileCount(child);
-        } else {
-            c++;
+    beginResetModel();
+
+    TreeItemArena *arena = m_arena;
+    m_arena = new TreeItemArena();
+    m_rootItem->removeChildren();
+    m_rootItem->setFetchedCount(0);
+
+    QMultiHash<uint, TreeItem*> pathIndex;
+    pathIndex.swap(m_pathIndex);
+    QSet<QString> strings;
+    strings.swap(m_strings);
+    m_fileCount = 0;
+    m_generation++;
+
+    endResetModel();
+
+    // Freeing a huge tree can take seconds, so we are doing it in a background thread.
+    QtConcurrent::run([arena, pathIndex, strings]() mutable {
+        delete arena;
+        pathIndex.clear();
+        strings.clear();
+    });
+}
+
+static void writeItem(QDataStream &out, const TreeItem *item)
+{
+    const TreeItemData &d = item->data();
+    out << item->name() << d.isFolder << quint8(item->checkState());
+
+    if (d.isFolder) {
+        const QVector<TreeItem*> children = item->childrenList();
+        out << qint32(children.size());
+        for (const TreeItem *child : children) {
+            writeItem(out, child);
         }
+    } else {
+        Compressor::Stats zipStats;
+        zipStats.type = d.zipType;
+        zipStats.iterations = d.zipIterations;
+        zipStats.gain = d.zipGain;
+
+        out << d.sizeBefore << d.lastModified << quint8(d.status) << d.sizeAfter << d.ratio
+            << d.statusText << item->outputPath() << zipStats << d.artifacts
+            << d.transferBefore << d.transferAfter;
     }
-    return c;
 }
 
-int TreeModel::calcFileCount()
+void TreeModel::save(QDataStream &out) const
 {
-    return _calcFileCount(rootItem());
+    const QVector<TreeItem*> children = m_rootItem->childrenList();
+    out << qint32(children.size());
+    for (const TreeItem *child : children) {
+        writeItem(out, child);
+    }
 }
 
-void TreeModel::itemEditFinished(TreeItem *item)
+// Items are filled before they are appended to the parent,
+// so folder stats are calculated only once per item.
+bool TreeModel::readChildren(QDataStream &in, TreeItem *parent, const QString &parentPath)
 {
-    emit dataChanged(index(item->row(), 0, QModelIndex()),
-                     index(item->row(), columnCount(), QModelIndex()));
+    qint32 count = 0;
+    in >> count;
+    if (count < 0) {
+        return false;
+    }
+
+    for (int i = 0; i < count && in.status() == QDataStream::Ok; ++i) {
+        QString name;
+        bool isFolder = false;
+        quint8 checkState = 0;
+        in >> name >> isFolder >> checkState;
+        if (name.isEmpty() || checkState > Qt::Checked) {
+            return false;
+        }
+
+        const QString path = parentPath.isEmpty() ? name : parentPath + '/' + name;
+        if (!parentPath.isEmpty()) {
+            name = intern(name);
+        }
+
+        TreeItem *item = nullptr;
+        if (isFolder) {
+            item = m_arena->create(name, true, 0, parent);
+            item->setCheckState(Qt::CheckState(checkState));
+            if (!readChildren(in, item, path)) {
+                return false;
+            }
+        } else {
+            qint64 sizeBefore = 0;
+            qint64 lastModified = 0;
+            quint8 status = 0;
+            qint64 sizeAfter = 0;
+            float ratio = 0;
+            QString statusText;
+            QString outPath;
+            Compressor::Stats zipStats;
+            QVector<Task::Output::Artifact> artifacts;
+            Transfer::Sizes transferBefore;
+            Transfer::Sizes transferAfter;
+            in >> sizeBefore >> lastModified >> status >> sizeAfter >> ratio
+               >> statusText >> outPath >> zipStats >> artifacts
+               >> transferBefore >> transferAfter;
+            if (status > quint8(Status::Unchanged)) {
+                return false;
+            }
+
+            item = m_arena->create(name, false, sizeBefore, parent);
+            item->setCheckState(Qt::CheckState(checkState));
+            item->setLastModified(lastModified);
+            item->setStatus(Status(status));
+            item->setSizeAfter(sizeAfter);
+            item->setRatio(ratio);
+            item->setStatusText(intern(statusText));
+            item->setOutputPath(outPath);
+            item->setZipStats(zipStats);
+            item->setArtifacts(artifacts);
+            item->setTransferSizes(transferBefore, transferAfter);
+            m_fileCount++;
+        }
+
+        addToIndex(item, path);
+        parent->appendChild(item);
+    }
+
+    parent->setFetchedCount(qMin(parent->childCount(), FetchBatchSize));
+
+    return in.status() == QDataStream::Ok;
 }
 
-void TreeModel::clear()
+// Replaces the current tree. Files are not checked here, see Session::findChanged().
+bool TreeModel::restore(QDataStream &in)
 {
-    beginRemoveRows(QModelIndex(), 0, rowCount());
-    m_rootItem->removeChildren();
-    endRemoveRows();
+    clear();
+
+    beginResetModel();
+    const bool ok = readChildren(in, m_rootItem, QString());
+    endResetModel();
+
+    if (!ok) {
+        clear();
+    }
+
+    return ok;
 }
@@ -23,9 +23,17 @@
 #pragma once
 
 #include <QAbstractItemModel>
+#include <QCache>
+#include <QDataStream>
+#include <QFileInfo>
+#include <QScopedPointer>
+#include <QSet>
 #include <QStyledItemDelegate>
 
+#include "cleaner.h"
+#include "compressor.h"
 #include "enums.h"
+#include "transfer.h"
 
 namespace Column
 {
@@ -35,6 +43,10 @@ namespace Column
         SizeBefore,
         SizeAfter,
         Ratio,
+        // Hidden unless transfer sizes are estimated.
+        TransferBefore,
+        TransferAfter,
+        TransferRatio,
         Status,
         LastColumn,
     };
@@ -43,98 +55,186 @@ namespace Column
 class StatusDelegate : public QStyledItemDelegate
 {
 public:
-    explicit StatusDelegate(QObject *parent = nullptr) : QStyledItemDelegate(parent) { }
+    explicit StatusDelegate(QObject *parent = nullptr);
 
 private:
     void paint(QPainter *p, const QStyleOptionViewItem &opt,
                const QModelIndex &index) const;
+
+    QPixmap statusPixmap(Status status, int size, qreal ratio, bool isEnabled) const;
+    void buildAtlas(int size, qreal ratio) const;
+
+private:
+    // Prerendered status icons for each size and pixel ratio the view was painted with.
+    mutable QHash<quint64, QPixmap> m_atlas;
 };
 
+// Running totals of all checked files inside a folder.
 struct FolderStats
 {
     qint64 sizeBefore = 0;
+    // The size of files that already have a result.
+    // Used to calculate a ratio while cleaning is still in progress.
+    qint64 processedSizeBefore = 0;
     qint64 sizeAfter = 0;
+    int fileCount = 0;
+    static const int StatusCount = int(Status::Unchanged) + 1;
+
+    int statusCount[StatusCount] = {}; // indexed by Status
+    // Of files with estimated transfer sizes only.
+    Transfer::Sizes transferBefore;
+    Transfer::Sizes transferAfter;
+
+    void add(const FolderStats &other, int sign = 1);
+    int count(Status status) const { return statusCount[int(status)]; }
 };
 
 struct TreeItemData
 {
-    QString title;
-    QString path;
-    QString outPath;
-    bool isFolder = false;
-
     qint64 sizeBefore = 0;
-    QString sizeBeforeText;
-
     qint64 sizeAfter = 0;
-    QString sizeAfterText;
-
     float ratio = 0;
-    QString ratioText;
-
     Status status = Status::None;
+    bool isFolder = false;
+    // Files only. In msecs since epoch.
+    qint64 lastModified = 0;
+    Compressor::Type zipType = Compressor::None;
+    // Reported by the built-in Zopfli only.
+    int zipIterations = 0;
+    int zipGain = 0;
+    // Sidecars mode only.
+    QVector<Task::Output::Artifact> artifacts;
+    // Estimated gzip/brotli sizes of the input and the cleaned SVG.
+    Transfer::Sizes transferBefore;
+    Transfer::Sizes transferAfter;
+    float transferRatio = 0;
+
+    // Usually shared between items. See TreeModel::intern().
     QString statusText;
+    // Only a file name when the output is next to the input, so the folder path
+    // is not stored per item. Shares the item name when the input was overwritten.
+    // Use TreeItem::outputPath() to get a full path.
+    QString outPath;
 };
 
+// Display strings are not stored in items. They are generated by TreeModel::data() on demand.
 class TreeItem
 {
 public:
-    TreeItem(const QString &path, TreeItem *parent = 0);
-    ~TreeItem();
+    TreeItem(const QString &name, bool isFolder, qint64 size, TreeItem *parent = nullptr);
 
     TreeItem *parent()                          { return m_parentItem; }
-    int row() const;
+    int row() const                             { return m_row; }
     Qt::ItemFlags flags() const;
 
+    // Top-level items store an absolute path as a name, all other items - a file name.
+    const QString& name() const                 { return m_name; }
+    QString title() const;
+    QString path() const;
+
     TreeItem *child(int row)                    { return m_childItems.value(row); }
     QVector<TreeItem *> childrenList() const    { return m_childItems; }
     int childCount() const                      { return m_childItems.count(); }
     bool hasChildren() const                    { return !m_childItems.isEmpty(); }
-    bool hasChild(const QString &path) const;
     bool appendChild(TreeItem *child);
+    // Children are owned by TreeItemArena, so they are not destroyed here.
     void removeChildren();
+    void removeChildren(int first, int count);
+    void collectFiles(QVector<TreeItem*> &files);
+
+    // Only the first `fetchedCount` children are exposed to the view.
+    int fetchedCount() const                    { return m_fetchedCount; }
+    void setFetchedCount(int count)             { m_fetchedCount = count; }
+    bool canFetchMore() const                   { return m_fetchedCount < m_childItems.count(); }
 
-    Qt::CheckState checkState()                 { return m_checkState; }
-    void setCheckState(Qt::CheckState state)    { m_checkState = state; }
+    Qt::CheckState checkState() const           { return m_checkState; }
+    void setCheckState(Qt::CheckState state);
 
-    bool isEnabled() const                      { return m_isEnabled; }
-    void setEnabled(bool flag)                  { m_isEnabled = flag; }
+    // An item is enabled when all its parents are checked.
+    bool isEnabled() const;
 
     void setSizeBefore(qint64 bytes);
     void setSizeAfter(qint64 bytes);
-    void setRatio(float ratio);
-    void setStatus(Status status)               { m_d.status = status; }
+    void setRatio(float ratio)                  { m_d.ratio = ratio; }
+    void setStatus(Status status);
     void setStatusText(const QString &text)     { m_d.statusText = text; }
-    void setOutputPath(const QString &path)     { m_d.outPath = path; }
+    void setOutputPath(const QString &path);
+    QString outputPath() const;
+    // The file was overwritten by the cleaner itself, so its result is still valid.
+    bool isOwnOutput(const QString &path, qint64 size) const;
+    void setLastModified(qint64 msecs)          { m_d.lastModified = msecs; }
+    void setZipStats(const Compressor::Stats &stats);
+    void setArtifacts(const QVector<Task::Output::Artifact> &list) { m_d.artifacts = list; }
+    void setTransferSizes(const Transfer::Sizes &before, const Transfer::Sizes &after);
     const TreeItemData& data() const            { return m_d; }
     bool isFolder() const                       { return m_d.isFolder; }
 
     void resetCleanerData();
 
-    FolderStats calcFolderStats();
+    // Folders only.
+    const FolderStats& folderStats() const      { return *m_stats; }
     bool hasFolderStats() const;
 
 private:
-    static QString prepareSize(qint64 bytes);
+    FolderStats contribution() const;
+    bool isAttached() const;
+    void updateParents(const FolderStats &oldContribution);
+    void addToStats(const FolderStats &stats);
 
 private:
     TreeItem * const m_parentItem;
+    QScopedPointer<FolderStats> m_stats;
 
+    QString m_name;
     TreeItemData m_d;
     QVector<TreeItem*> m_childItems;
-    bool m_isEnabled = true;
+    int m_row = 0;
+    int m_fetchedCount = 0;
     Qt::CheckState m_checkState = Qt::Checked;
 };
 
+// Allocates tree items in large blocks, so a tree with hundreds of thousands
+// of items can be freed at once, without per-item deallocations.
+class TreeItemArena
+{
+public:
+    TreeItemArena() = default;
+    ~TreeItemArena();
+
+    TreeItem *create(const QString &name, bool isFolder, qint64 size, TreeItem *parent);
+    void destroy(TreeItem *item);
+
+private:
+    Q_DISABLE_COPY(TreeItemArena)
+
+    static const int BlockSize = 4096;
+
+    QVector<TreeItem*> m_blocks;
+    int m_blockUsed = BlockSize;
+    QVector<TreeItem*> m_freeItems;
+};
+
 class TreeModel : public QAbstractItemModel
 {
 public:
-    enum class AddResult
+    struct AddSummary
     {
-        Ok,
-        FileExists,
-        FolderExists,
-        Empty,
+        int files = 0;
+        int duplicates = 0;
+        int symlinks = 0;
+        int emptyFolders = 0;
+        int unsupported = 0;
+        // Added top-level items.
+        QVector<TreeItem*> items;
+    };
+
+    struct RefreshSummary
+    {
+        int added = 0;
+        int removed = 0;
+        int modified = 0;
+        // New and modified files.
+        QVector<TreeItem*> changedFiles;
     };
 
     explicit TreeModel(QObject *parent = nullptr);
@@ -151,23 +251,72 @@ public:
     QModelIndex parent(const QModelIndex &index) const;
     int rowCount(const QModelIndex &parent = QModelIndex()) const;
     int columnCount(const QModelIndex &parent = QModelIndex()) const;
+    bool hasChildren(const QModelIndex &parent = QModelIndex()) const;
+    bool canFetchMore(const QModelIndex &parent) const;
+    void fetchMore(const QModelIndex &parent);
+    void fetchAll();
     void itemEditFinished(TreeItem *item);
+    void itemsEditFinished(const QVector<TreeItem *> &items);
 
-    AddResult addFolder(const QString &path);
-    AddResult addFile(const QString &path, TreeItem *parent = nullptr);
+    AddSummary addPaths(const QStringList &paths);
+    RefreshSummary refresh();
+    // Missing items are kept when `removeMissing` is false,
+    // so their pointers stay valid while cleaning is in progress.
+    RefreshSummary refreshFolder(const QString &path, bool removeMissing);
+    bool refreshFile(const QFileInfo &fi, TreeItem *item);
 
     TreeItem *itemByIndex(const QModelIndex &index) const;
     TreeItem *rootItem() const;
+    TreeItem *findItem(const QString &path) const;
+
+    QString intern(const QString &str);
+    QString sizeText(qint64 bytes) const;
 
     bool isEmpty() const;
     void clear();
 
-    void calcFoldersStats();
-    int calcFileCount();
+    int fileCount() const;
+    const FolderStats& stats() const;
+
+    // Incremented each time existing items are destroyed,
+    // so pointers collected before can be checked for validity.
+    int generation() const                      { return m_generation; }
+
+    // Check states can't be changed while cleaning is in progress.
+    void setChecksLocked(bool flag)             { m_isChecksLocked = flag; }
+
+    void save(QDataStream &out) const;
+    bool restore(QDataStream &in);
 
 private:
     void scanFolder(const QString &path, TreeItem *parent);
+    void syncFolder(const QString &path, TreeItem *folder, bool recursive,
+                    bool removeMissing, RefreshSummary &summary);
+    void appendItems(TreeItem *parent, const QVector<TreeItem*> &items);
+    void removeItems(TreeItem *parent, const QVector<int> &rows);
+    void destroyItem(TreeItem *item);
+    bool isExposed(TreeItem *item) const;
+    void subtreeChanged(TreeItem *parent);
+    void addToIndex(TreeItem *item, const QString &path);
+    bool readChildren(QDataStream &in, TreeItem *parent, const QString &parentPath);
+
+    QString ratioText(float ratio) const;
+    QString transferToolTip(const Transfer::Sizes &sizes) const;
 
 private:
+    TreeItemArena *m_arena;
     TreeItem * const m_rootItem;
+
+    // Path hashes of all files and folders in the tree. Used to detect duplicates
+    // without walking the tree and without storing full paths.
+    QMultiHash<uint, TreeItem*> m_pathIndex;
+    int m_fileCount = 0;
+    int m_generation = 0;
+    bool m_isChecksLocked = false;
+
+    // File names and status messages are mostly the same, so we share them.
+    QSet<QString> m_strings;
+
+    mutable QCache<qint64, QString> m_sizeTexts;
+    mutable QCache<int, QString> m_ratioTexts;
 };
@@ -0,0 +1,178 @@
+/****************************************************************************
+**
+** SVG Cleaner could help you to clean up your SVG files
+** from unnecessary data.
+** Copyright (C) 2012-2018 Evgeniy Reizner
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License along
+** with this program; if not, write to the Free Software Foundation, Inc.,
+** 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+**
+****************************************************************************/
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+
+#ifdef WITH_ZOPFLI
+#include <zopfli.h>
+
+// Not declared by the installed zopfli.h, but exported by the library.
+extern "C" void ZopfliDeflatePart(const ZopfliOptions *options, int btype, int final,
+                                  const unsigned char *in, size_t instart, size_t inend,
+                                  unsigned char *bp, unsigned char **out, size_t *outsize);
+#endif
+
+#include "zopflilib.h"
+
+bool ZopfliLib::isAvailable() noexcept
+{
+#ifdef WITH_ZOPFLI
+    return true;
+#else
+    return false;
+#endif
+}
+
+static QString errorMsg()
+{
+    return QCoreApplication::translate("ZopfliLib", "Failed to compress a file.");
+}
+
+#ifdef WITH_ZOPFLI
+
+static QByteArray compressOnce(const QByteArray &data, int iterations)
+{
+    ZopfliOptions opt;
+    ZopfliInitOptions(&opt);
+    opt.numiterations = iterations;
+
+    unsigned char *out = nullptr;
+    size_t outSize = 0;
+    ZopfliCompress(&opt, ZOPFLI_FORMAT_GZIP,
+                   reinterpret_cast<const unsigned char*>(data.constData()), size_t(data.size()),
+                   &out, &outSize);
+    if (!out) {
+        throw errorMsg();
+    }
+
+    const QByteArray ba(reinterpret_cast<const char*>(out), int(outSize));
+    free(out);
+    return ba;
+}
+
+// Zopfli doesn't report progress between iterations, so it's restarted with a doubled
+// iterations count. It keeps the best pass, and passes are deterministic, so a longer run
+// is never worse than a shorter one.
+//
+// All passes together never take more than `maxIterations`, so a file that keeps improving
+// costs the same as a single pass with `maxIterations`. A pass that would not fit into
+// the time budget, judging by the previous one, is shortened or skipped.
+ZopfliLib::Result ZopfliLib::compress(const QByteArray &data, int maxIterations, int patience,
+                                      int timeBudgetMs)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    Result res;
+    res.iterations = qMin(qMax(1, patience), maxIterations);
+    res.data = compressOnce(data, res.iterations);
+    const int firstSize = res.data.size();
+
+    int spent = res.iterations;
+    qint64 lastPassMs = timer.elapsed();
+    int lastPassIterations = res.iterations;
+
+    forever {
+        int iterations = qMin(res.iterations * 2, maxIterations - spent);
+
+        const qint64 elapsed = timer.elapsed();
+        const qint64 msPerIteration = qMax(qint64(1), lastPassMs / lastPassIterations);
+        iterations = int(qMin(qint64(iterations), (timeBudgetMs - elapsed) / msPerIteration));
+
+        // a pass that is not longer than the best one can't improve it
+        if (iterations <= res.iterations) {
+            break;
+        }
+
+        QElapsedTimer passTimer;
+        passTimer.start();
+        const QByteArray ba = compressOnce(data, iterations);
+        lastPassMs = passTimer.elapsed();
+        lastPassIterations = iterations;
+        spent += iterations;
+
+        if (ba.size() >= res.data.size()) {
+            break;
+        }
+
+        res.data = ba;
+        res.iterations = iterations;
+    }
+
+    res.gain = firstSize - res.data.size();
+    return res;
+}
+
+QByteArray ZopfliLib::deflateBlock(const QByteArray &data, int start, int size, int iterations,
+                                   bool isLast)
+{
+    static const int WindowSize = 32 * 1024;
+
+    ZopfliOptions opt;
+    ZopfliInitOptions(&opt);
+    opt.numiterations = iterations;
+
+    const int windowStart = qMax(0, start - WindowSize);
+    const auto bytes = reinterpret_cast<const unsigned char*>(data.constData()) + windowStart;
+
+    unsigned char bp = 0;
+    unsigned char *out = nullptr;
+    size_t outSize = 0;
+    // dynamic Huffman codes
+    ZopfliDeflatePart(&opt, 2, isLast, bytes, size_t(start - windowStart),
+                      size_t(start - windowStart + size), &bp, &out, &outSize);
+    if (!out) {
+        return QByteArray();
+    }
+
+    QByteArray ba(reinterpret_cast<const char*>(out), int(outSize));
+    free(out);
+
+    // Same as a zlib sync flush: an empty stored block, so the next block starts
+    // at a byte boundary. `bp` is the number of used bits in the last byte,
+    // and the 3 header bits don't fit into it when it's full or almost full.
+    if (!isLast) {
+        if (bp == 0 || bp > 5) {
+            ba.append('\0');
+        }
+        ba.append("\x00\x00\xff\xff", 4);
+    }
+
+    return ba;
+}
+
+#else
+
+ZopfliLib::Result ZopfliLib::compress(const QByteArray &/*data*/, int /*maxIterations*/,
+                                      int /*patience*/, int /*timeBudgetMs*/)
+{
+    throw errorMsg();
+}
+
+QByteArray ZopfliLib::deflateBlock(const QByteArray &/*data*/, int /*start*/, int /*size*/,
+                                   int /*iterations*/, bool /*isLast*/)
+{
+    return QByteArray();
+}
+
+#endif
@@ -0,0 +1,56 @@
+/****************************************************************************
+**
+** SVG Cleaner could help you to clean up your SVG files
+** from unnecessary data.
+** Copyright (C) 2012-2018 Evgeniy Reizner
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License along
+** with this program; if not, write to the Free Software Foundation, Inc.,
+** 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+**
+****************************************************************************/
+
+#pragma once
+
+#include <QByteArray>
+
+// An in-process Zopfli encoder with an adaptive iterations count.
+//
+// It's available only when built with WITH_ZOPFLI.
+namespace ZopfliLib
+{
+    struct Result
+    {
+        QByteArray data;
+        // The iterations count of the returned result.
+        int iterations = 0;
+        // Bytes saved compared to the first pass of `patience` iterations.
+        qint64 gain = 0;
+    };
+
+    bool isAvailable() noexcept;
+
+    // Compresses data to gzip. It starts with `patience` iterations, and the count is doubled
+    // until the output size stops improving, iterations of all passes reach `maxIterations`
+    // or the next pass would not fit into `timeBudgetMs`.
+    //
+    // Throws a QString on error.
+    Result compress(const QByteArray &data, int maxIterations, int patience, int timeBudgetMs);
+
+    // Same as Gzip::deflateBlock(), but with Zopfli. Up to 32KiB before `start` are used
+    // as a window, like in pigz.
+    //
+    // Returns an empty array on error.
+    QByteArray deflateBlock(const QByteArray &data, int start, int size, int iterations,
+                            bool isLast);
+}
@@ -22,13 +22,18 @@ CONFIG += C++11
 
 SOURCES += \
     src/aboutdialog.cpp \
+    src/calibrationdialog.cpp \
     src/cleaner.cpp \
     src/compressor.cpp \
     src/detailsdialog.cpp \
+    src/dictionary.cpp \
     src/doc.cpp \
     src/enums.cpp \
     src/filesview.cpp \
+    src/folderwatcher.cpp \
+    src/gzip.cpp \
     src/iconutils.cpp \
+    src/journal.cpp \
     src/main.cpp \
     src/mainwindow.cpp \
     src/preferences/attributespage.cpp \
@@ -43,18 +48,29 @@ SOURCES += \
     src/preferences/widgets/iconlistview.cpp \
     src/preferences/widgets/warningcheckbox.cpp \
     src/process.cpp \
+    src/resultqueue.cpp \
+    src/resultsproxymodel.cpp \
+    src/scheduler.cpp \
+    src/session.cpp \
     src/settings.cpp \
-    src/treemodel.cpp
+    src/transfer.cpp \
+    src/treemodel.cpp \
+    src/zopflilib.cpp
 
 HEADERS += \
     src/aboutdialog.h \
+    src/calibrationdialog.h \
     src/cleaner.h \
     src/compressor.h \
     src/detailsdialog.h \
+    src/dictionary.h \
     src/doc.h \
     src/enums.h \
     src/filesview.h \
+    src/folderwatcher.h \
+    src/gzip.h \
     src/iconutils.h \
+    src/journal.h \
     src/mainwindow.h \
     src/preferences/attributespage.h \
     src/preferences/basepreferencespage.h \
@@ -68,12 +84,20 @@ HEADERS += \
     src/preferences/widgets/iconlistview.h \
     src/preferences/widgets/warningcheckbox.h \
     src/process.h \
+    src/resultqueue.h \
+    src/resultsproxymodel.h \
+    src/runconfig.h \
+    src/scheduler.h \
+    src/session.h \
     src/settings.h \
+    src/transfer.h \
     src/treemodel.h \
-    src/utils.h
+    src/utils.h \
+    src/zopflilib.h
 
 FORMS += \
     src/aboutdialog.ui \
+    src/calibrationdialog.ui \
     src/detailsdialog.ui \
     src/mainwindow.ui \
     src/preferences/attributespage.ui \
@@ -82,6 +106,22 @@ FORMS += \
     src/preferences/outputpage.ui \
     src/preferences/pathspage.ui
 
+contains(DEFINES, WITH_LIBDEFLATE) {
+    LIBS += -ldeflate
+}
+
+contains(DEFINES, WITH_ZLIB) {
+    LIBS += -lz
+}
+
+contains(DEFINES, WITH_ZOPFLI) {
+    LIBS += -lzopfli
+}
+
+contains(DEFINES, WITH_BROTLI) {
+    LIBS += -lbrotlienc
+}
+
 contains(DEFINES, WITH_CHECK_UPDATES) {
     SOURCES += src/updater.cpp
     HEADERS += src/updater.h
@@ -0,0 +1,142 @@
+/****************************************************************************
+**
+** SVG Cleaner could help you to clean up your SVG files
+** from unnecessary data.
+** Copyright (C) 2012-2018 Evgeniy Reizner
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License along
+** with this program; if not, write to the Free Software Foundation, Inc.,
+** 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+**
+****************************************************************************/
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDataStream>
+#include <QFile>
+#include <QTextStream>
+
+#ifdef Q_OS_LINUX
+#include <unistd.h>
+#endif
+
+#include "treemodel.h"
+
+// Reports how much memory the tree takes per item.
+//
+// The tree is restored from a synthetic session, so no files are needed.
+// Memory is measured as a resident set size growth, which is available on Linux only.
+
+static qint64 residentSize()
+{
+#ifdef Q_OS_LINUX
+    QFile file("/proc/self/statm");
+    if (!file.open(QFile::ReadOnly)) {
+        return -1;
+    }
+
+    // the second field is a resident set size in pages
+    const QList<QByteArray> fields = file.readAll().split(' ');
+    if (fields.size() < 2) {
+        return -1;
+    }
+
+    return fields.at(1).toLongLong() * sysconf(_SC_PAGESIZE);
+#else
+    return -1;
+#endif
+}
+
+// Writes a single top-level folder with `folders` subfolders of `filesPerFolder` files each,
+// in the TreeModel::save() format.
+static QByteArray genSession(int folders, int filesPerFolder, bool isProcessed)
+{
+    const QString root = "/home/user/projects/icons";
+    const QString warning = "Warning: the file is bigger after cleaning.";
+
+    QByteArray data;
+    QDataStream out(&data, QIODevice::WriteOnly);
+    out.setVersion(QDataStream::Qt_5_6);
+
+    out << qint32(1) << root << true << quint8(Qt::Checked) << qint32(folders);
+    for (int i = 0; i < folders; ++i) {
+        const QString folder = QString("folder-%1").arg(i);
+        out << folder << true << quint8(Qt::Checked) << qint32(filesPerFolder);
+        for (int j = 0; j < filesPerFolder; ++j) {
+            const QString name = QString("icon-%1-%2.svg").arg(i).arg(j);
+            out << name << false << quint8(Qt::Checked)
+                << qint64(4000 + j) << qint64(1500000000000 + j);
+
+            if (isProcessed) {
+                // every tenth file has a warning, the rest are ok
+                const bool isWarning = j % 10 == 0;
+                const QString outPath = QString("%1/%2/icon-%3-%4_min.svg")
+                                        .arg(root, folder).arg(i).arg(j);
+                out << quint8(isWarning ? Status::Warning : Status::Ok)
+                    << qint64(2500 + j) << 37.5f
+                    << (isWarning ? warning : QString()) << outPath;
+            } else {
+                out << quint8(Status::None) << qint64(0) << 0.0f << QString() << QString();
+            }
+        }
+    }
+
+    return data;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Reports the memory usage of the files tree.");
+    parser.addHelpOption();
+    parser.addOption({ "files", "Total files count.", "count", "500000" });
+    parser.addOption({ "per-folder", "Files per folder.", "count", "1000" });
+    parser.addOption({ "processed", "Fill items with cleaning results." });
+    parser.process(app);
+
+    const int perFolder = qMax(1, parser.value("per-folder").toInt());
+    const int folders = qMax(1, parser.value("files").toInt() / perFolder);
+
+    QTextStream out(stdout);
+
+    // generated before the measurement, so the buffer is not counted
+    const QByteArray session = genSession(folders, perFolder, parser.isSet("processed"));
+
+    TreeModel model;
+    const qint64 before = residentSize();
+
+    QDataStream in(session);
+    in.setVersion(QDataStream::Qt_5_6);
+    if (!model.restore(in)) {
+        out << "Error: failed to build a tree.\n";
+        return 1;
+    }
+
+    const qint64 after = residentSize();
+
+    // folders are items too
+    const qint64 items = qint64(folders) * perFolder + folders + 1;
+    out << "Items: " << items << '\n';
+    out << "sizeof(TreeItem): " << sizeof(TreeItem) << " bytes\n";
+    if (before < 0 || after < 0) {
+        out << "Memory usage can't be measured on this platform.\n";
+        return 0;
+    }
+
+    out << "Total: " << (after - before) / 1024 << " KiB\n";
+    out << "Per item: " << (after - before) / items << " bytes\n";
+
+    return 0;
+}
@@ -0,0 +1,51 @@
+QT += core gui widgets concurrent svg
+
+CONFIG += c++11
+
+TARGET = treebench
+CONFIG += console
+CONFIG -= app_bundle
+
+TEMPLATE = app
+
+DEFINES += QT_NO_FOREACH
+
+INCLUDEPATH += ../../src
+
+SOURCES += \
+    main.cpp \
+    ../../src/compressor.cpp \
+    ../../src/enums.cpp \
+    ../../src/gzip.cpp \
+    ../../src/iconutils.cpp \
+    ../../src/process.cpp \
+    ../../src/transfer.cpp \
+    ../../src/treemodel.cpp \
+    ../../src/zopflilib.cpp
+
+HEADERS += \
+    ../../src/cleaner.h \
+    ../../src/compressor.h \
+    ../../src/enums.h \
+    ../../src/gzip.h \
+    ../../src/iconutils.h \
+    ../../src/process.h \
+    ../../src/transfer.h \
+    ../../src/treemodel.h \
+    ../../src/zopflilib.h
+
+contains(DEFINES, WITH_LIBDEFLATE) {
+    LIBS += -ldeflate
+}
+
+contains(DEFINES, WITH_ZLIB) {
+    LIBS += -lz
+}
+
+contains(DEFINES, WITH_ZOPFLI) {
+    LIBS += -lzopfli
+}
+
+contains(DEFINES, WITH_BROTLI) {
+    LIBS += -lbrotlienc
+}
@@ -0,0 +1,206 @@
+/****************************************************************************
+**
+** SVG Cleaner could help you to clean up your SVG files
+** from unnecessary data.
+** Copyright (C) 2012-2018 Evgeniy Reizner
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License along
+** with this program; if not, write to the Free Software Foundation, Inc.,
+** 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+**
+****************************************************************************/
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDirIterator>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <QDebug>
+
+#include "compressor.h"
+
+// Compares compressors on a set of SVG files at each compression level.
+//
+// External compressors are looked up in the executable folder, like in the GUI,
+// so 7za and zopfli should be copied next to the zipbench.
+
+struct Stats
+{
+    qint64 inSize = 0;
+    qint64 outSize = 0;
+    qint64 elapsedNs = 0;
+    int mismatches = 0;
+    // built-in Zopfli only
+    qint64 iterations = 0;
+    qint64 zipGain = 0;
+};
+
+static const char *levelNames[] = { "Lowest", "Low", "Normal", "Optimal", "Ultra" };
+
+static QByteArray readFile(const QString &path)
+{
+    QFile file(path);
+    if (!file.open(QFile::ReadOnly)) {
+        throw QString("Failed to read a file: '%1'.").arg(path);
+    }
+
+    return file.readAll();
+}
+
+static void copyFile(const QString &from, const QString &to)
+{
+    QFile::remove(to);
+    if (!QFile::copy(from, to)) {
+        throw QString("Failed to copy a file: '%1'.").arg(from);
+    }
+}
+
+static QStringList findFiles(const QString &dir)
+{
+    QStringList files;
+    QDirIterator it(dir, { "*.svg" }, QDir::Files, QDirIterator::Subdirectories);
+    while (it.hasNext()) {
+        files << it.next();
+    }
+    files.sort();
+    return files;
+}
+
+static Stats runBench(const Compressor &c, Compressor::Level lvl, const QStringList &files,
+                      const QString &workDir, bool verify)
+{
+    const QString inPath = workDir + "/in.svg";
+    const QString outPath = workDir + "/in.svgz";
+    const QString checkPath = workDir + "/check.svg";
+
+    Stats stats;
+    QElapsedTimer timer;
+    for (const QString &file : files) {
+        // zip() removes the input file
+        copyFile(file, inPath);
+
+        timer.start();
+        const auto zipStats = c.zip(lvl, inPath, outPath);
+        stats.elapsedNs += timer.nsecsElapsed();
+        stats.iterations += zipStats.iterations;
+        stats.zipGain += zipStats.gain;
+
+        stats.inSize += QFile(file).size();
+        stats.outSize += QFile(outPath).size();
+
+        // the output must be readable by other gzip decoders
+        if (verify && c.outputSuffix() == "z") {
+            Compressor::unzip(outPath, checkPath);
+            if (readFile(checkPath) != readFile(file)) {
+                stats.mismatches++;
+                qDebug() << "Roundtrip mismatch:" << file;
+            }
+        }
+    }
+
+    return stats;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+    a.setApplicationName("zipbench");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Compares SVGZ compressors on a set of SVG files.");
+    parser.addHelpOption();
+    parser.addPositionalArgument("dir", "A folder with SVG files.");
+
+    QCommandLineOption compressorsOpt(QStringList("compressors"),
+        "A comma-separated list of compressors (default: 7za,deflate).", "list", "7za,deflate");
+    parser.addOption(compressorsOpt);
+
+    QCommandLineOption verifyOpt(QStringList("verify"),
+        "Decompress each file with 7za and compare with the original.");
+    parser.addOption(verifyOpt);
+
+    parser.process(a);
+
+    if (parser.positionalArguments().size() != 1) {
+        parser.showHelp(1);
+    }
+
+    const QStringList files = findFiles(parser.positionalArguments().first());
+    if (files.isEmpty()) {
+        qDebug() << "No SVG files found.";
+        return 1;
+    }
+
+    QTemporaryDir dir;
+    if (!dir.isValid()) {
+        qDebug() << "Failed to create temp dir.";
+        return 1;
+    }
+
+    QTextStream out(stdout);
+    out << QString("%1 %2 %3 %4 %5\n")
+           .arg("Compressor", -12).arg("Level", -8).arg("Args", -16)
+           .arg("Ratio", 8).arg("MiB/s", 8);
+
+    try {
+        const QStringList known = {
+            CompressorName::SevenZip, CompressorName::Zopfli, CompressorName::Deflate,
+            CompressorName::BestOf, CompressorName::Brotli, CompressorName::Zstd
+        };
+
+        for (QString name : parser.value(compressorsOpt).split(',')) {
+            name = name.trimmed();
+            if (!known.contains(name)) {
+                qDebug() << "Unknown compressor:" << name;
+                continue;
+            }
+
+            const Compressor c = Compressor::fromName(name);
+            if (!c.isAvailable()) {
+                qDebug() << "Compressor is not available:" << name;
+                continue;
+            }
+
+            for (int i = Compressor::Lowest; i <= Compressor::Ultra; ++i) {
+                const auto lvl = Compressor::Level(i);
+                const Stats stats = runBench(c, lvl, files, dir.path(), parser.isSet(verifyOpt));
+
+                const double ratio = double(stats.outSize) / stats.inSize * 100;
+                const double speed = double(stats.inSize) / (1 << 20)
+                                     / (qMax<qint64>(stats.elapsedNs, 1) / 1e9);
+
+                out << QString("%1 %2 %3 %4 %5")
+                       .arg(c.name(), -12).arg(levelNames[i], -8)
+                       .arg(c.levelToString(lvl), -16)
+                       .arg(QString::number(ratio, 'f', 2) + "%", 8)
+                       .arg(QString::number(speed, 'f', 2), 8);
+                if (stats.iterations > 0) {
+                    out << QString(" (avg %1 iterations, %2 bytes gained)")
+                           .arg(double(stats.iterations) / files.size(), 0, 'f', 1)
+                           .arg(stats.zipGain);
+                }
+                if (stats.mismatches > 0) {
+                    out << QString(" (%1 mismatches)").arg(stats.mismatches);
+                }
+                out << endl;
+            }
+        }
+    } catch (const QString &s) {
+        qDebug().noquote() << s;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,38 @@
+QT += core widgets concurrent
+
+CONFIG += c++11
+
+TARGET = zipbench
+CONFIG += console
+CONFIG -= app_bundle
+
+TEMPLATE = app
+
+DEFINES += QT_NO_FOREACH
+
+INCLUDEPATH += ../../src
+
+SOURCES += \
+    main.cpp \
+    ../../src/compressor.cpp \
+    ../../src/gzip.cpp \
+    ../../src/process.cpp \
+    ../../src/zopflilib.cpp
+
+HEADERS += \
+    ../../src/compressor.h \
+    ../../src/gzip.h \
+    ../../src/process.h \
+    ../../src/zopflilib.h
+
+contains(DEFINES, WITH_LIBDEFLATE) {
+    LIBS += -ldeflate
+}
+
+contains(DEFINES, WITH_ZLIB) {
+    LIBS += -lz
+}
+
+contains(DEFINES, WITH_ZOPFLI) {
+    LIBS += -lzopfli
+}